@@ -0,0 +1,181 @@
+/*
+ * Distributed camera fleet.
+ *
+ * The fleet is made of groups of cameras and clients, each group on its own
+ * CSMA LAN behind a router. The group routers are connected to a core router
+ * by point-to-point backbone links, and the groups are split between the MPI
+ * ranks with IotFleetPartitionHelper. The clients of a group watch the
+ * cameras of the next group, so the traffic crosses the backbone and the
+ * rank boundaries.
+ *
+ * Every rank writes the statistics of its own applications, then the totals
+ * of all ranks are summed on rank 0.
+ *
+ *   mpirun -np 4 ./ns3 run "iot-distributed-fleet --Groups=8 --CamerasPerGroup=16"
+ */
+
+#include <ns3/applications-module.h>
+#include <ns3/core-module.h>
+#include <ns3/csma-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/mpi-interface.h>
+#include <ns3/network-module.h>
+#include <ns3/point-to-point-module.h>
+
+#include <mpi.h>
+
+#include <array>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("IotDistributedFleet");
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t groups = 4;
+    uint32_t camerasPerGroup = 8;
+    uint32_t clientsPerCamera = 1;
+    double simTimeSec = 60;
+    std::string profile = "./scratch/tapo-c200-move.json";
+    std::string statsPrefix = "fleet-stats";
+    bool nullMessage = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("Groups", "Number of groups of cameras and clients.", groups);
+    cmd.AddValue("CamerasPerGroup", "Number of cameras of each group.", camerasPerGroup);
+    cmd.AddValue("ClientsPerCamera", "Number of clients watching each camera.", clientsPerCamera);
+    cmd.AddValue("SimulationTime", "Length of simulation in seconds.", simTimeSec);
+    cmd.AddValue("Profile", "Traffic profile of the cameras.", profile);
+    cmd.AddValue("StatsPrefix", "Prefix of the per-rank statistics files.", statsPrefix);
+    cmd.AddValue("NullMessage", "Use the null message synchronization algorithm.", nullMessage);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(groups == 0 || groups > 255, "Groups must be between 1 and 255.");
+
+    Time::SetResolution(Time::NS);
+    GlobalValue::Bind("SimulatorImplementationType",
+                      StringValue(nullMessage ? "ns3::NullMessageSimulatorImpl"
+                                              : "ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(&argc, &argv);
+
+    uint32_t systemId = MpiInterface::GetSystemId();
+    uint32_t systemCount = MpiInterface::GetSize();
+    IotFleetPartitionHelper partition(systemId, systemCount, groups);
+
+    // Every rank creates the whole topology, in the same order, and only
+    // simulates the nodes it owns. The core router belongs to rank 0.
+    NodeContainer core;
+    core.Create(1, 0);
+    std::vector<NodeContainer> routers(groups);
+    std::vector<NodeContainer> cameras(groups);
+    std::vector<NodeContainer> clients(groups);
+    for (uint32_t g = 0; g < groups; ++g)
+    {
+        routers[g] = partition.CreateGroupNodes(g, 1);
+        cameras[g] = partition.CreateGroupNodes(g, camerasPerGroup);
+        clients[g] = partition.CreateGroupNodes(g, camerasPerGroup * clientsPerCamera);
+    }
+
+    InternetStackHelper internet;
+    internet.InstallAll();
+
+    // The backbone delay is the lookahead of the distributed simulation
+    PointToPointHelper backbone;
+    backbone.SetDeviceAttribute("DataRate", StringValue("1Gbps"));
+    backbone.SetChannelAttribute("Delay", StringValue("2ms"));
+
+    CsmaHelper lan;
+    lan.SetChannelAttribute("DataRate", StringValue("100Mbps"));
+    lan.SetChannelAttribute("Delay", StringValue("50us"));
+
+    Ipv4AddressHelper address;
+    std::vector<Ipv4InterfaceContainer> cameraInterfaces(groups);
+    for (uint32_t g = 0; g < groups; ++g)
+    {
+        NetDeviceContainer backboneDevices = backbone.Install(core.Get(0), routers[g].Get(0));
+        std::ostringstream backboneNetwork;
+        backboneNetwork << "10.255." << g << ".0";
+        address.SetBase(backboneNetwork.str().c_str(), "255.255.255.252");
+        address.Assign(backboneDevices);
+
+        NodeContainer lanNodes(routers[g], cameras[g], clients[g]);
+        NetDeviceContainer lanDevices = lan.Install(lanNodes);
+        std::ostringstream lanNetwork;
+        lanNetwork << "10." << g << ".0.0";
+        address.SetBase(lanNetwork.str().c_str(), "255.255.0.0");
+        Ipv4InterfaceContainer lanInterfaces = address.Assign(lanDevices);
+        for (uint32_t i = 0; i < camerasPerGroup; ++i)
+        {
+            cameraInterfaces[g].Add(lanInterfaces.Get(1 + i));
+        }
+    }
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    Ptr<IotStatsCollector> stats = CreateObject<IotStatsCollector>();
+    stats->SetAttribute("ThroughputInterval", TimeValue(Seconds(0)));
+
+    // Streams are numbered by camera, not by rank, so that the traffic does
+    // not depend on the number of ranks
+    uint16_t cameraPort = 8800;
+    IotPassiveAppHelper cameraHelper(Address(Ipv4Address::GetAny()), cameraPort);
+    cameraHelper.SetTrafficProfile(profile);
+    cameraHelper.SetStartJitter(Seconds(1));
+    // The start jitter, then one stream per camera plus one per sub-flow
+    int64_t streamsPerGroup = 1 + camerasPerGroup * (1 + TrafficProfileLoader::Load(profile).size());
+
+    for (uint32_t g = 0; g < groups; ++g)
+    {
+        cameraHelper.SetFirstStream(g * streamsPerGroup);
+        ApplicationContainer cameraApps = partition.Install(cameraHelper, cameras[g]);
+        cameraApps.Stop(Seconds(simTimeSec));
+        stats->Attach(cameraApps);
+
+        // Clients watch the cameras of the next group
+        uint32_t watched = (g + 1) % groups;
+        for (uint32_t i = 0; i < clients[g].GetN(); ++i)
+        {
+            Ipv4Address cameraAddress = cameraInterfaces[watched].GetAddress(i / clientsPerCamera);
+            IotClientHelper clientHelper(Address(cameraAddress), cameraPort);
+            clientHelper.SetAttribute("StartTime", TimeValue(Seconds(2)));
+            clientHelper.SetAttribute("StopTime", TimeValue(Seconds(simTimeSec - 1)));
+            stats->Attach(partition.Install(clientHelper, clients[g].Get(i)));
+        }
+    }
+
+    Simulator::Stop(Seconds(simTimeSec));
+    Simulator::Run();
+
+    std::ostringstream statsFile;
+    statsFile << statsPrefix << "-rank" << systemId << ".json";
+    stats->WriteSummary(statsFile.str());
+
+    // Merge the totals of all ranks on rank 0
+    std::array<uint64_t, 4> local{};
+    stats->ForEachFlow([&local](uint32_t, bool tx, uint16_t, const IotStatsCollector::FlowStats& flow) {
+        local[tx ? 0 : 2] += flow.sizes.GetCount();
+        local[tx ? 1 : 3] += flow.bytes;
+    });
+    std::array<uint64_t, 4> total{};
+    MPI_Reduce(local.data(),
+               total.data(),
+               static_cast<int>(local.size()),
+               MPI_UINT64_T,
+               MPI_SUM,
+               0,
+               MpiInterface::GetCommunicator());
+
+    if (systemId == 0)
+    {
+        std::cout << "ranks " << systemCount << ", cameras " << groups * camerasPerGroup
+                  << ", clients " << groups * camerasPerGroup * clientsPerCamera << "\n"
+                  << "tx packets " << total[0] << ", tx bytes " << total[1] << "\n"
+                  << "rx packets " << total[2] << ", rx bytes " << total[3] << "\n"
+                  << "per-rank statistics in " << statsPrefix << "-rank*.json" << std::endl;
+    }
+
+    Simulator::Destroy();
+    MpiInterface::Disable();
+    return 0;
+}
@@ -47,33 +47,28 @@ void TraceIotRxPacket(Ptr<const Packet> packet, const Address& from)
     }    
 }
 
-void
-LoadTapoC200TraficProfile(Ptr<IotPassiveApp> iotApp)
+std::vector<std::shared_ptr<SubFlow>>
+LoadTapoC200TraficProfile()
 {
     std::vector<std::shared_ptr<SubFlow>> trafficProfile;
 
-    std::shared_ptr<RandomGenerator> payloadSizeGen1 = std::make_shared<RandomGeneratorNormal>(691, 1448, 744.381, 191.231);
-    std::shared_ptr<RandomGenerator> interPacketTimeGen1 = std::make_shared<RandomGeneratorNormal>(0.000008, 2.02, 0.059936, 0.077852);
-    std::shared_ptr<SubFlow> subFlow1 = std::make_shared<SubFlow>(1, payloadSizeGen1, interPacketTimeGen1);
-    trafficProfile.push_back(subFlow1);
+    trafficProfile.push_back(std::make_shared<SubFlow>(1,
+        RandomGeneratorNormal(691, 1448, 744.381, 191.231),
+        RandomGeneratorNormal(0.000008, 2.02, 0.059936, 0.077852)));
 
-    std::shared_ptr<RandomGenerator> payloadSizeGen2 = std::make_shared<RandomGeneratorNormal>(883, 1448, 977.167, 230.66);
-    std::shared_ptr<RandomGenerator> interPacketTimeGen2 = std::make_shared<RandomGeneratorUniform>(5.046386, 21.891857);
-    std::shared_ptr<SubFlow> subFlow2 = std::make_shared<SubFlow>(2, payloadSizeGen2, interPacketTimeGen2);
-    trafficProfile.push_back(subFlow2);
+    trafficProfile.push_back(std::make_shared<SubFlow>(2,
+        RandomGeneratorNormal(883, 1448, 977.167, 230.66),
+        RandomGeneratorUniform(5.046386, 21.891857)));
 
-    std::shared_ptr<RandomGenerator> payloadSizeGen3 = std::make_shared<RandomGeneratorNormal>(2004, 202720, 7761.412, 11299.521);
-    std::shared_ptr<RandomGenerator> interPacketTimeGen3 = std::make_shared<RandomGeneratorNormal>(0.000006, 0.252874, 0.065435, 0.021381);
-    std::shared_ptr<SubFlow> subFlow3 = std::make_shared<SubFlow>(3, payloadSizeGen3, interPacketTimeGen3);
-    trafficProfile.push_back(subFlow3);
+    trafficProfile.push_back(std::make_shared<SubFlow>(3,
+        RandomGeneratorNormal(2004, 202720, 7761.412, 11299.521),
+        RandomGeneratorNormal(0.000006, 0.252874, 0.065435, 0.021381)));
 
-    std::shared_ptr<RandomGenerator> payloadSizeGen4 = std::make_shared<RandomGeneratorNormal>(5, 1420, 730.692, 451.447);
-    std::shared_ptr<RandomGenerator> interPacketTimeGen4 = std::make_shared<RandomGeneratorNormal>(0.087334, 5.042865, 0.941867, 0.927757);
-    std::shared_ptr<SubFlow> subFlow4 = std::make_shared<SubFlow>(4, payloadSizeGen4, interPacketTimeGen4);
-    trafficProfile.push_back(subFlow4);
-
-    iotApp->SetTrafficProfile(trafficProfile);
+    trafficProfile.push_back(std::make_shared<SubFlow>(4,
+        RandomGeneratorNormal(5, 1420, 730.692, 451.447),
+        RandomGeneratorNormal(0.087334, 5.042865, 0.941867, 0.927757)));
 
+    return trafficProfile;
 }
 int 
 main(int argc, char* argv[]) 
@@ -140,10 +135,12 @@ main(int argc, char* argv[])
     Ipv4Address cameraAddress = cameraInterface.GetAddress(0);
     uint16_t cameraPort = 8800;
     IotPassiveAppHelper cameraHelper(Address(cameraAddress), cameraPort);
-    ApplicationContainer cameraApps = cameraHelper.Install(wifiCameraNode.Get(0));
+    cameraHelper.SetTrafficProfile(LoadTapoC200TraficProfile());
+    // Fixed streams: the traffic only depends on --RngRun
+    cameraHelper.SetFirstStream(0);
+    ApplicationContainer cameraApps = cameraHelper.Install(wifiCameraNode);
     Ptr<IotPassiveApp> iotApp = cameraApps.Get(0)->GetObject<IotPassiveApp>();
 
-    LoadTapoC200TraficProfile(iotApp);
     iotApp->SetStartTime(Seconds(0.0));
     iotApp->TraceConnectWithoutContext("Tx", MakeCallback(&TraceIotTxPacket));
 
@@ -0,0 +1,313 @@
+/*
+ * Scaling benchmark of IotPassiveApp and IotClient.
+ *
+ * Every camera shares a CSMA LAN with its clients, which keeps the network
+ * cost low and linear in the number of nodes. The benchmark sweeps the
+ * number of cameras, of clients per camera and of sub-flows per camera, and
+ * prints one CSV line per configuration with the wall-clock time, the
+ * simulated events and packets per second and the peak resident set size.
+ *
+ * Each configuration runs in a child process so that its peak RSS is its
+ * own:
+ *
+ *   ./ns3 run "iot-scale-benchmark --Cameras=10,100,1000 --SubFlows=1,4"
+ *
+ * With --Profile, the cameras send a traffic profile file instead of the
+ * synthetic sub-flows, for instance the Tapo scenario:
+ *
+ *   ./ns3 run "iot-scale-benchmark --Profile=scratch/tapo-c200-move.json --Cameras=1,10,100"
+ *
+ * --Protocols compares the TCP and UDP transports of the applications:
+ *
+ *   ./ns3 run "iot-scale-benchmark --Protocols=Tcp,Udp --Cameras=100"
+ */
+
+#include <ns3/applications-module.h>
+#include <ns3/core-module.h>
+#include <ns3/csma-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/network-module.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("IotScaleBenchmark");
+
+namespace
+{
+
+/// Measures of one configuration.
+struct BenchmarkResult
+{
+    double wallSeconds{0};  ///< Wall-clock time of Simulator::Run.
+    uint64_t events{0};     ///< Simulated events.
+    uint64_t packets{0};    ///< Packets sent by the cameras.
+    uint64_t bytes{0};      ///< Bytes sent by the cameras.
+    long peakRssKb{0};      ///< Peak resident set size, in kilobytes.
+};
+
+/// Packets and bytes sent by the cameras of the current configuration.
+uint64_t g_txPackets = 0;
+uint64_t g_txBytes = 0;
+
+void
+CountTx(Ptr<const Packet> packet, const Address&, uint16_t)
+{
+    g_txPackets++;
+    g_txBytes += packet->GetSize();
+}
+
+/**
+ * Synthetic camera profile: sub-flows of increasing period.
+ * \param subFlows Number of sub-flows.
+ * \return The profile.
+ */
+std::vector<std::shared_ptr<SubFlow>>
+MakeProfile(uint32_t subFlows)
+{
+    std::vector<std::shared_ptr<SubFlow>> trafficProfile;
+    for (uint32_t i = 0; i < subFlows; ++i)
+    {
+        trafficProfile.push_back(std::make_shared<SubFlow>(i + 1,
+            RandomGeneratorNormal(200, 1448, 800, 300),
+            RandomGeneratorUniform(0.01, 0.05 * (i + 1))));
+    }
+    return trafficProfile;
+}
+
+/**
+ * Simulate one configuration.
+ * \param cameras Number of cameras.
+ * \param clientsPerCamera Number of clients of each camera.
+ * \param trafficProfile Traffic profile of the cameras.
+ * \param protocol Socket factory of the applications, TCP or UDP.
+ * \param simTimeSec Simulated time, in seconds.
+ * \return The measures, without the peak RSS.
+ */
+BenchmarkResult
+RunScenario(uint32_t cameras,
+            uint32_t clientsPerCamera,
+            const std::vector<std::shared_ptr<SubFlow>>& trafficProfile,
+            TypeId protocol,
+            double simTimeSec)
+{
+    g_txPackets = 0;
+    g_txBytes = 0;
+
+    NodeContainer cameraNodes;
+    cameraNodes.Create(cameras);
+    NodeContainer clientNodes;
+    clientNodes.Create(cameras * clientsPerCamera);
+
+    InternetStackHelper internet;
+    internet.Install(cameraNodes);
+    internet.Install(clientNodes);
+
+    CsmaHelper lan;
+    lan.SetChannelAttribute("DataRate", StringValue("100Mbps"));
+    lan.SetChannelAttribute("Delay", StringValue("50us"));
+
+    Ipv4AddressHelper address;
+    address.SetBase("10.0.0.0", "255.255.255.0");
+    std::vector<Ipv4Address> cameraAddresses;
+    for (uint32_t c = 0; c < cameras; ++c)
+    {
+        NodeContainer lanNodes(cameraNodes.Get(c));
+        for (uint32_t i = 0; i < clientsPerCamera; ++i)
+        {
+            lanNodes.Add(clientNodes.Get(c * clientsPerCamera + i));
+        }
+        Ipv4InterfaceContainer interfaces = address.Assign(lan.Install(lanNodes));
+        cameraAddresses.push_back(interfaces.GetAddress(0));
+        address.NewNetwork();
+    }
+
+    uint16_t cameraPort = 8800;
+    IotPassiveAppHelper cameraHelper(Address(Ipv4Address::GetAny()), cameraPort);
+    cameraHelper.SetTrafficProfile(trafficProfile);
+    cameraHelper.SetAttribute("Protocol", TypeIdValue(protocol));
+    cameraHelper.SetStartJitter(Seconds(1));
+    cameraHelper.SetFirstStream(0);
+    ApplicationContainer cameraApps = cameraHelper.Install(cameraNodes);
+    cameraApps.Stop(Seconds(simTimeSec));
+    for (auto it = cameraApps.Begin(); it != cameraApps.End(); ++it)
+    {
+        (*it)->TraceConnectWithoutContext("Tx", MakeCallback(&CountTx));
+    }
+
+    for (uint32_t c = 0; c < cameras; ++c)
+    {
+        IotClientHelper clientHelper(Address(cameraAddresses[c]), cameraPort);
+        clientHelper.SetAttribute("StartTime", TimeValue(Seconds(1)));
+        clientHelper.SetAttribute("Protocol", TypeIdValue(protocol));
+        for (uint32_t i = 0; i < clientsPerCamera; ++i)
+        {
+            clientHelper.Install(clientNodes.Get(c * clientsPerCamera + i));
+        }
+    }
+
+    Simulator::Stop(Seconds(simTimeSec));
+    auto start = std::chrono::steady_clock::now();
+    Simulator::Run();
+    auto stop = std::chrono::steady_clock::now();
+
+    BenchmarkResult result;
+    result.wallSeconds = std::chrono::duration<double>(stop - start).count();
+    result.events = Simulator::GetEventCount();
+    result.packets = g_txPackets;
+    result.bytes = g_txBytes;
+    Simulator::Destroy();
+    return result;
+}
+
+/**
+ * Simulate one configuration in a child process.
+ * \param cameras Number of cameras.
+ * \param clientsPerCamera Number of clients of each camera.
+ * \param trafficProfile Traffic profile of the cameras.
+ * \param protocol Socket factory of the applications, TCP or UDP.
+ * \param simTimeSec Simulated time, in seconds.
+ * \return The measures, with the peak RSS of the child.
+ */
+BenchmarkResult
+RunInChild(uint32_t cameras,
+           uint32_t clientsPerCamera,
+           const std::vector<std::shared_ptr<SubFlow>>& trafficProfile,
+           TypeId protocol,
+           double simTimeSec)
+{
+    int fds[2];
+    NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe failed");
+    std::cout.flush();
+
+    pid_t pid = fork();
+    NS_ABORT_MSG_IF(pid < 0, "fork failed");
+    if (pid == 0)
+    {
+        close(fds[0]);
+        BenchmarkResult result = RunScenario(cameras, clientsPerCamera, trafficProfile, protocol, simTimeSec);
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    BenchmarkResult result;
+    ssize_t received = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    NS_ABORT_MSG_IF(received != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0,
+                    "Benchmark child failed for " << cameras << " cameras");
+    result.peakRssKb = usage.ru_maxrss;
+    return result;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    std::string cameraCounts = "1,10,100";
+    std::string clientCounts = "1";
+    std::string subFlowCounts = "1,4";
+    std::string profile;
+    std::string protocols = "Tcp";
+    double simTimeSec = 30;
+    std::string output;
+    bool fork = true;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("Cameras", "Comma-separated camera counts.", cameraCounts);
+    cmd.AddValue("ClientsPerCamera", "Comma-separated client counts per camera.", clientCounts);
+    cmd.AddValue("SubFlows", "Comma-separated sub-flow counts per camera.", subFlowCounts);
+    cmd.AddValue("Profile",
+                 "Traffic profile file of the cameras. If set, it replaces the synthetic "
+                 "sub-flows and SubFlows is ignored.",
+                 profile);
+    cmd.AddValue("Protocols", "Comma-separated transport protocols: Tcp, Udp.", protocols);
+    cmd.AddValue("SimulationTime", "Simulated time of each configuration, in seconds.", simTimeSec);
+    cmd.AddValue("Output", "CSV file to write, standard output if empty.", output);
+    cmd.AddValue("Fork",
+                 "Run each configuration in a child process. Otherwise the peak RSS "
+                 "is the peak of the whole sweep.",
+                 fork);
+    cmd.Parse(argc, argv);
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output, std::ios::out | std::ios::trunc);
+        NS_ABORT_MSG_IF(!file.is_open(), "Unable to open the file " << output);
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+
+    // The profile file, or one synthetic profile per sub-flow count
+    std::vector<std::vector<std::shared_ptr<SubFlow>>> trafficProfiles;
+    if (profile.empty())
+    {
+        for (const std::string& subFlows : SplitString(subFlowCounts, ","))
+        {
+            trafficProfiles.push_back(MakeProfile(std::stoul(subFlows)));
+        }
+    }
+    else
+    {
+        trafficProfiles.push_back(TrafficProfileLoader::Load(profile));
+    }
+
+    std::vector<std::pair<std::string, TypeId>> transports;
+    for (const std::string& name : SplitString(protocols, ","))
+    {
+        NS_ABORT_MSG_IF(name != "Tcp" && name != "Udp", "Unknown protocol " << name);
+        transports.emplace_back(name,
+                                name == "Tcp" ? TcpSocketFactory::GetTypeId()
+                                              : UdpSocketFactory::GetTypeId());
+    }
+
+    out << "cameras,clients_per_camera,sub_flows,protocol,simulation_time,wall_seconds,events,"
+           "events_per_second,packets,packets_per_second,bytes,peak_rss_kb"
+        << std::endl;
+    for (const std::string& cameraCount : SplitString(cameraCounts, ","))
+    {
+        uint32_t cameras = std::stoul(cameraCount);
+        for (const std::string& clientCount : SplitString(clientCounts, ","))
+        {
+            uint32_t clientsPerCamera = std::stoul(clientCount);
+            for (const auto& trafficProfile : trafficProfiles)
+            {
+                for (const auto& [protocolName, protocol] : transports)
+                {
+                    BenchmarkResult result;
+                    if (fork)
+                    {
+                        result = RunInChild(cameras, clientsPerCamera, trafficProfile, protocol, simTimeSec);
+                    }
+                    else
+                    {
+                        result = RunScenario(cameras, clientsPerCamera, trafficProfile, protocol, simTimeSec);
+                        struct rusage usage;
+                        getrusage(RUSAGE_SELF, &usage);
+                        result.peakRssKb = usage.ru_maxrss;
+                    }
+
+                    out << cameras << "," << clientsPerCamera << "," << trafficProfile.size() << ","
+                        << protocolName << "," << simTimeSec << "," << result.wallSeconds << ","
+                        << result.events << "," << result.events / result.wallSeconds << ","
+                        << result.packets << "," << result.packets / result.wallSeconds << ","
+                        << result.bytes << "," << result.peakRssKb << std::endl;
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("IotTraceToCsv");
+
+// Convert a binary file written by IotTraceRecorder into CSV.
+int 
+main(int argc, char* argv[]) 
+{
+    std::string input = "iot-packets.bin";
+    std::string output = "iot-packets.csv";
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("Input", "Binary file written by IotTraceRecorder.", input);
+    cmd.AddValue("Output", "CSV file to write.", output);
+    cmd.Parse(argc, argv);
+
+    IotTraceRecorder::ConvertToCsv(input, output);
+
+    return 0;
+}
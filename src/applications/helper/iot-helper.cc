@@ -1,4 +1,8 @@
 #include "iot-helper.h"
+#include <ns3/abort.h>
+#include <ns3/iot-passive-app.h>
+#include <ns3/node.h>
+#include <ns3/traffic-profile-loader.h>
 #include <ns3/uinteger.h>
 
 namespace ns3 {
@@ -20,7 +24,125 @@ IotPassiveAppHelper::IotPassiveAppHelper(const Address& address, uint16_t port)
     {
         m_factory.Set("LocalAddress", AddressValue(address));
         m_factory.Set("LocalPort", UintegerValue(port));
+        m_startJitter = CreateObject<UniformRandomVariable>();
     }
 
+int64_t
+IotPassiveAppHelper::AssignStreams(ApplicationContainer apps, int64_t stream)
+{
+    int64_t currentStream = stream;
+    for (auto it = apps.Begin(); it != apps.End(); ++it)
+    {
+        Ptr<IotPassiveApp> app = DynamicCast<IotPassiveApp>(*it);
+        if (app)
+        {
+            currentStream += app->AssignStreams(currentStream);
+        }
+    }
+    return (currentStream - stream);
+}
+
+void
+IotPassiveAppHelper::SetTrafficProfile(const std::vector<std::shared_ptr<SubFlow>>& trafficProfile)
+{
+    m_trafficProfile = trafficProfile;
+}
+
+void
+IotPassiveAppHelper::SetTrafficProfile(const std::string& filename)
+{
+    m_trafficProfile = TrafficProfileLoader::Load(filename);
+}
+
+void
+IotPassiveAppHelper::SetStartJitter(Time maxJitter)
+{
+    m_maxStartJitter = maxJitter;
+}
+
+void
+IotPassiveAppHelper::SetFirstStream(int64_t stream)
+{
+    m_startJitter->SetStream(stream);
+    m_nextStream = stream + 1;
+}
+
+Ptr<Application>
+IotPassiveAppHelper::DoInstall(Ptr<Node> node)
+{
+    Ptr<Application> app = ApplicationHelper::DoInstall(node);
+    Ptr<IotPassiveApp> iotApp = DynamicCast<IotPassiveApp>(app);
+
+    if (!m_trafficProfile.empty())
+    {
+        iotApp->SetTrafficProfile(m_trafficProfile);
+    }
+    if (m_maxStartJitter.IsStrictlyPositive())
+    {
+        TimeValue startTime;
+        app->GetAttribute("StartTime", startTime);
+        Time jitter = Seconds(m_startJitter->GetValue(0, m_maxStartJitter.GetSeconds()));
+        app->SetStartTime(startTime.Get() + jitter);
+    }
+    if (m_nextStream >= 0)
+    {
+        m_nextStream += iotApp->AssignStreams(m_nextStream);
+    }
+    return app;
+}
+
+
+// IOT FLEET PARTITION HELPER /////////////////////////////////////////////////
+
+IotFleetPartitionHelper::IotFleetPartitionHelper(uint32_t systemId, uint32_t systemCount, uint32_t groupCount)
+    : m_systemId(systemId),
+      m_systemCount(systemCount),
+      m_groupCount(groupCount)
+{
+    NS_ABORT_MSG_IF(systemCount == 0 || systemId >= systemCount, "Invalid system id " << systemId);
+    NS_ABORT_MSG_IF(groupCount == 0, "The fleet needs at least one group.");
+}
+
+uint32_t
+IotFleetPartitionHelper::GetGroupOwner(uint32_t group) const
+{
+    NS_ABORT_MSG_IF(group >= m_groupCount, "Invalid group " << group);
+    // Contiguous blocks whose sizes differ by at most one group
+    return static_cast<uint32_t>(static_cast<uint64_t>(group) * m_systemCount / m_groupCount);
+}
+
+NodeContainer
+IotFleetPartitionHelper::CreateGroupNodes(uint32_t group, uint32_t count) const
+{
+    NodeContainer nodes;
+    nodes.Create(count, GetGroupOwner(group));
+    return nodes;
+}
+
+bool
+IotFleetPartitionHelper::IsLocal(Ptr<Node> node) const
+{
+    return node->GetSystemId() == m_systemId;
+}
+
+NodeContainer
+IotFleetPartitionHelper::GetLocalNodes(NodeContainer nodes) const
+{
+    NodeContainer local;
+    for (auto it = nodes.Begin(); it != nodes.End(); ++it)
+    {
+        if (IsLocal(*it))
+        {
+            local.Add(*it);
+        }
+    }
+    return local;
+}
+
+ApplicationContainer
+IotFleetPartitionHelper::Install(ApplicationHelper& helper, NodeContainer nodes) const
+{
+    return helper.Install(GetLocalNodes(nodes));
+}
 
 } // namespace ns3
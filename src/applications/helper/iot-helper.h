@@ -1,7 +1,14 @@
 #ifndef IOT_HELPER
 #define IOT_HELPER
 
+#include <memory>
+#include <string>
+#include <vector>
 #include <ns3/application-helper.h>
+#include <ns3/node-container.h>
+#include <ns3/nstime.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/sub-flow.h>
 
 namespace ns3 
 {
@@ -25,6 +32,10 @@ public:
 /**
  * \ingroup applications
  * Helper to make it easier to instantiate a IotPassiveApp on a set of nodes.
+ *
+ * Every application installed by the helper can be given the same shared
+ * traffic profile, a random start offset and fixed random streams, so that
+ * a whole fleet is set up by a single Install call.
  */
 class IotPassiveAppHelper : public ApplicationHelper {
 public:
@@ -36,6 +47,131 @@ public:
      */
     IotPassiveAppHelper(const Address& address, uint16_t port);
 
+    using ApplicationHelper::AssignStreams;
+
+    /**
+     * Assign fixed random variable streams to the traffic profiles of the
+     * given IotPassiveApp applications, in container order.
+     * \param apps The applications, with their traffic profile already set.
+     * \param stream First stream index to use.
+     * \return The number of stream indices assigned.
+     */
+    int64_t AssignStreams(ApplicationContainer apps, int64_t stream);
+
+    /**
+     * Set the traffic profile of the applications installed from now on.
+     * The SubFlow objects are shared by all of them.
+     * \param trafficProfile The traffic profile.
+     */
+    void SetTrafficProfile(const std::vector<std::shared_ptr<SubFlow>>& trafficProfile);
+
+    /**
+     * Set the traffic profile of the applications installed from now on,
+     * loaded with TrafficProfileLoader.
+     * \param filename Path of the JSON profile.
+     */
+    void SetTrafficProfile(const std::string& filename);
+
+    /**
+     * Delay the start of each application installed from now on by a
+     * uniform random offset in [0, maxJitter), added to its StartTime, so
+     * that a fleet does not start in a synchronized burst.
+     *
+     * The offset is written into StartTime at Install, so a later
+     * ApplicationContainer::Start or Application::SetStartTime replaces it
+     * along with the start time. Set the start time with
+     * SetAttribute("StartTime", ...) before Install instead.
+     * \param maxJitter Upper bound of the offset, zero to disable it.
+     */
+    void SetStartJitter(Time maxJitter);
+
+    /**
+     * Assign fixed random variable streams to the applications installed
+     * from now on, in installation order, starting at \p stream. The start
+     * jitter draws from \p stream itself.
+     * \param stream First stream index to use.
+     */
+    void SetFirstStream(int64_t stream);
+
+protected:
+    /**
+     * Create an application on a node and apply the traffic profile, the
+     * start jitter and the streams set on the helper.
+     * \param node The node.
+     * \return The application.
+     */
+    Ptr<Application> DoInstall(Ptr<Node> node) override;
+
+private:
+    std::vector<std::shared_ptr<SubFlow>> m_trafficProfile; ///< Profile shared by the applications.
+    Time m_maxStartJitter;                    ///< Upper bound of the start offset.
+    Ptr<UniformRandomVariable> m_startJitter; ///< Draws the start offsets.
+    int64_t m_nextStream{-1};                 ///< Next stream to assign, negative if disabled.
+};
+
+/**
+ * \ingroup applications
+ * Helper to partition a fleet of cameras and clients between the ranks of
+ * a distributed simulation.
+ *
+ * The fleet is made of groups (e.g. the floors of a building) which are
+ * split into contiguous, balanced blocks of ranks: every node of a group is
+ * created with the system id of the rank owning the group, and
+ * applications are only installed on the nodes owned by the local rank.
+ * Links between groups owned by different ranks must be point-to-point.
+ *
+ * The helper does not depend on MPI: the local system id and the number of
+ * systems are given by the caller, typically from MpiInterface.
+ */
+class IotFleetPartitionHelper
+{
+public:
+    /**
+     * \param systemId System id of the local rank.
+     * \param systemCount Number of ranks.
+     * \param groupCount Number of groups of the fleet.
+     */
+    IotFleetPartitionHelper(uint32_t systemId, uint32_t systemCount, uint32_t groupCount);
+
+    /**
+     * \param group A group of the fleet.
+     * \return The system id of the rank owning the group.
+     */
+    uint32_t GetGroupOwner(uint32_t group) const;
+
+    /**
+     * Create the nodes of a group, owned by the rank owning the group.
+     * Nodes must be created on every rank, in the same order.
+     * \param group The group.
+     * \param count Number of nodes to create.
+     * \return The nodes.
+     */
+    NodeContainer CreateGroupNodes(uint32_t group, uint32_t count) const;
+
+    /**
+     * \param node A node.
+     * \return true if the node is simulated by the local rank.
+     */
+    bool IsLocal(Ptr<Node> node) const;
+
+    /**
+     * \param nodes Some nodes.
+     * \return The nodes simulated by the local rank.
+     */
+    NodeContainer GetLocalNodes(NodeContainer nodes) const;
+
+    /**
+     * Install applications on the nodes simulated by the local rank only.
+     * \param helper The application helper.
+     * \param nodes The nodes.
+     * \return The applications installed by the local rank.
+     */
+    ApplicationContainer Install(ApplicationHelper& helper, NodeContainer nodes) const;
+
+private:
+    uint32_t m_systemId;    ///< System id of the local rank.
+    uint32_t m_systemCount; ///< Number of ranks.
+    uint32_t m_groupCount;  ///< Number of groups.
 };
 
 } // namespace ns3
@@ -1,10 +1,13 @@
 #include "iot-client.h"
+#include "iot-passive-app.h"
 #include <ns3/log.h>
 #include <ns3/inet-socket-address.h>
 #include <ns3/inet6-socket-address.h>
 #include <ns3/socket.h>
 #include <ns3/simulator.h>
 #include <ns3/tcp-socket-factory.h>
+#include <ns3/udp-socket-factory.h>
+#include <ns3/packet.h>
 #include <ns3/uinteger.h>
 
 NS_LOG_COMPONENT_DEFINE("IotClient");
@@ -14,7 +17,7 @@ namespace ns3 {
 NS_OBJECT_ENSURE_REGISTERED(IotClient);
 
 IotClient::IotClient()
-    : m_socket(nullptr), m_remotePort(0), m_sendBufferSize(1024) {
+    : m_socket(nullptr), m_remotePort(0), m_sendBufferSize(1024), m_subscribeInterval(Seconds(1)) {
     NS_LOG_FUNCTION(this);
 }
 
@@ -32,11 +35,23 @@ TypeId IotClient::GetTypeId() {
                                           UintegerValue(8080),
                                           MakeUintegerAccessor(&IotClient::m_remotePort),
                                           MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("Protocol",
+                                          "The type of protocol to use. Must match the protocol of the "
+                                          "remote IotPassiveApp.",
+                                          TypeIdValue(TcpSocketFactory::GetTypeId()),
+                                          MakeTypeIdAccessor(&IotClient::m_tid),
+                                          MakeTypeIdChecker())
                             .AddAttribute("SendBufferSize",
                                           "The size of the buffer for sending data.",
                                           UintegerValue(1024),
                                           MakeUintegerAccessor(&IotClient::m_sendBufferSize),
                                           MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("SubscribeInterval",
+                                          "With UDP, delay after which the SUBSCRIBE datagram is sent "
+                                          "again if no traffic has been received yet.",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&IotClient::m_subscribeInterval),
+                                          MakeTimeChecker(Time(1)))
                             .AddTraceSource("Rx",
                                             "Trace for received packets.",
                                             MakeTraceSourceAccessor(&IotClient::m_rxTrace),
@@ -50,6 +65,7 @@ TypeId IotClient::GetTypeId() {
 
 void IotClient::DoDispose() {
     NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_subscribeEvent);
     m_socket = nullptr;
     Application::DoDispose();
 }
@@ -58,7 +74,7 @@ void IotClient::StartApplication() {
     NS_LOG_FUNCTION(this);
 
     if (!m_socket) {
-        m_socket = Socket::CreateSocket(GetNode(), TcpSocketFactory::GetTypeId());
+        m_socket = Socket::CreateSocket(GetNode(), m_tid);
         m_socket->SetConnectCallback(
             MakeCallback(&IotClient::ConnectionSucceededCallback, this),
             MakeCallback(&IotClient::ConnectionFailedCallback, this));
@@ -82,7 +98,11 @@ void IotClient::StartApplication() {
 void IotClient::StopApplication() {
     NS_LOG_FUNCTION(this);
 
+    Simulator::Cancel(m_subscribeEvent);
     if (m_socket) {
+        if (m_socket->GetSocketType() == Socket::NS3_SOCK_DGRAM) {
+            SendControl(IotUdpControl::UNSUBSCRIBE);
+        }
         m_socket->Close();
         m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());        
         m_socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());        
@@ -96,6 +116,32 @@ void IotClient::StopApplication() {
 void IotClient::ConnectionSucceededCallback(Ptr<Socket> socket) {
     NS_LOG_FUNCTION(this << socket);
     NS_LOG_INFO("Connection to remote IoT application succeeded.");
+
+    if (socket->GetSocketType() == Socket::NS3_SOCK_DGRAM) {
+        // The remote application only streams to subscribed addresses
+        Subscribe();
+    }
+}
+
+void IotClient::Subscribe() {
+    NS_LOG_FUNCTION(this);
+
+    // Repeated until the first datagram arrives; the remote application
+    // ignores the SUBSCRIBE datagrams of an address already subscribed
+    SendControl(IotUdpControl::SUBSCRIBE);
+    m_subscribeEvent = Simulator::Schedule(m_subscribeInterval, &IotClient::Subscribe, this);
+}
+
+void IotClient::SendControl(IotUdpControl control) {
+    NS_LOG_FUNCTION(this << static_cast<uint32_t>(control));
+
+    uint8_t data = static_cast<uint8_t>(control);
+    Ptr<Packet> packet = Create<Packet>(&data, 1);
+    if (m_socket->Send(packet) < 0) {
+        NS_LOG_ERROR("Failed to send control datagram. Socket error: " << m_socket->GetErrno());
+        return;
+    }
+    m_txTrace(packet);
 }
 
 void IotClient::ConnectionFailedCallback(Ptr<Socket> socket) {
@@ -114,6 +160,8 @@ void IotClient::ReceivedDataCallback(Ptr<Socket> socket) {
         if (packetSize == 0) {
             break; // EOF
         }
+        // Subscribed: the traffic has started
+        Simulator::Cancel(m_subscribeEvent);
         if (InetSocketAddress::IsMatchingType(from))
         {
             InetSocketAddress inetSocketAddress = InetSocketAddress::ConvertFrom(from);
@@ -3,19 +3,27 @@
 
 #include <ns3/address.h>
 #include <ns3/application.h>
+#include <ns3/event-id.h>
+#include <ns3/nstime.h>
 #include <ns3/traced-callback.h>
 
 namespace ns3 {
 
 class Socket;
 class Packet;
+enum class IotUdpControl : uint8_t;
 
 /**
  * \ingroup applications
  * Simple client application for sending and receiving data.
  *
  * This application establishes a connection to a remote IOT application,
- * sends data, and handles incoming data.
+ * sends data, and handles incoming data. With the UDP protocol, it
+ * subscribes to the remote application when started and unsubscribes when
+ * stopped. The SUBSCRIBE datagram is sent again every SubscribeInterval
+ * until the first datagram of the remote application arrives, so that a
+ * lost datagram or a remote application starting later does not leave the
+ * client without traffic.
  */
 class IotClient : public Application {
 public:
@@ -53,6 +61,18 @@ private:
      */
     void ReceivedDataCallback(Ptr<Socket> socket);
 
+    /**
+     * Send a control datagram to the remote application (UDP only).
+     * \param control The control message.
+     */
+    void SendControl(IotUdpControl control);
+
+    /**
+     * Send a SUBSCRIBE datagram and schedule the next one, until traffic
+     * arrives (UDP only).
+     */
+    void Subscribe();
+
     /// The socket for sending and receiving data.
     Ptr<Socket> m_socket;
 
@@ -62,8 +82,17 @@ private:
     /// Remote port.
     uint16_t m_remotePort;
 
+    /// The type of protocol to use.
+    TypeId m_tid;
+
     /// Buffer size for sending data.
     uint32_t m_sendBufferSize;
+
+    /// Delay between two SUBSCRIBE datagrams while no traffic is received.
+    Time m_subscribeInterval;
+
+    /// Next SUBSCRIBE datagram.
+    EventId m_subscribeEvent;
     
     /// Trace for received packets.
     TracedCallback<Ptr<const Packet>, const Address&> m_rxTrace;
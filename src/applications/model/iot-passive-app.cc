@@ -1,23 +1,81 @@
 #include "iot-passive-app.h"
 
+#include <ns3/abort.h>
 #include <ns3/log.h>
 #include <ns3/inet-socket-address.h>
 #include <ns3/inet6-socket-address.h>
 #include <ns3/socket.h>
 #include <ns3/tcp-socket-factory.h>
+#include <ns3/udp-socket-factory.h>
+#include <ns3/packet.h>
 #include <ns3/simulator.h>
 #include <ns3/uinteger.h>
+#include <ns3/boolean.h>
+#include <algorithm>
+#include <functional>
 #include <random>
+#include <sstream>
 #include <ns3/pointer.h>
 
 NS_LOG_COMPONENT_DEFINE("IotPassiveApp");
 
 namespace ns3 {
 
+namespace
+{
+
+/**
+ * Format the IP address and port of a socket address for logging.
+ * \param address The socket address.
+ * \return The address and port, in the form "<ip> port <port>".
+ */
+std::string
+SocketAddressToString(const Address& address)
+{
+    std::ostringstream oss;
+    if (InetSocketAddress::IsMatchingType(address))
+    {
+        InetSocketAddress inetSocketAddress = InetSocketAddress::ConvertFrom(address);
+        oss << inetSocketAddress.GetIpv4() << " port " << inetSocketAddress.GetPort();
+    }
+    else if (Inet6SocketAddress::IsMatchingType(address))
+    {
+        Inet6SocketAddress inetSocket6Address = Inet6SocketAddress::ConvertFrom(address);
+        oss << inetSocket6Address.GetIpv6() << " port " << inetSocket6Address.GetPort();
+    }
+    else
+    {
+        oss << address;
+    }
+    return oss.str();
+}
+
+/*
+ * Streams of the generator states of the connections, from the most
+ * significant bits: a flag keeping them clear of the streams handed out by
+ * AssignStreams, the application stream, the ordinal of the connection,
+ * then the streams of its sub-flows.
+ */
+
+/// Flag of the streams of the connections.
+constexpr uint64_t CONNECTION_STREAM_FLAG = 1ULL << 62;
+/// Bits of the application stream.
+constexpr unsigned APP_STREAM_BITS = 22;
+/// Bits of the ordinal of a connection.
+constexpr unsigned CONNECTION_ORDINAL_BITS = 26;
+/// Bits of the streams of the sub-flows of one connection.
+constexpr unsigned SUB_FLOW_STREAM_BITS = 14;
+
+static_assert(APP_STREAM_BITS + CONNECTION_ORDINAL_BITS + SUB_FLOW_STREAM_BITS == 62,
+              "The connection streams must fit below their flag");
+
+} // namespace
+
 NS_OBJECT_ENSURE_REGISTERED(IotPassiveApp);
 
 IotPassiveApp::IotPassiveApp()
-    : m_listeningSocket(nullptr), m_state(AppState::NOT_STARTED) 
+    : m_listeningSocket(nullptr), m_state(AppState::NOT_STARTED), m_multiplexSends(false),
+      m_maxSendBacklog(0), m_maxDatagramSize(1472) 
 {
     NS_LOG_FUNCTION(this);
 }
@@ -37,14 +95,59 @@ TypeId IotPassiveApp::GetTypeId()
                                           UintegerValue(8800),
                                           MakeUintegerAccessor(&IotPassiveApp::m_localPort),
                                           MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("Protocol",
+                                          "The type of protocol to use. With TCP, clients connect to the "
+                                          "application. With UDP, clients subscribe with a datagram and "
+                                          "the traffic is streamed back to their address.",
+                                          TypeIdValue(TcpSocketFactory::GetTypeId()),
+                                          MakeTypeIdAccessor(&IotPassiveApp::m_tid),
+                                          MakeTypeIdChecker())
+                            .AddAttribute("MaxDatagramSize",
+                                          "Maximum payload of a UDP datagram. Larger payloads are split "
+                                          "into several datagrams.",
+                                          UintegerValue(1472),
+                                          MakeUintegerAccessor(&IotPassiveApp::m_maxDatagramSize),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("MultiplexSends",
+                                          "If true, the sends of all sub-flows of all connections are kept "
+                                          "in a local queue served by a single simulator event, instead of "
+                                          "one simulator event per sub-flow and connection.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&IotPassiveApp::m_multiplexSends),
+                                          MakeBooleanChecker())
+                            .AddAttribute("MaxSendBacklog",
+                                          "Maximum number of bytes waiting in the send queue of a connection. "
+                                          "Payloads that do not fit are dropped and reported by the Drop trace "
+                                          "source. 0 means unlimited.",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&IotPassiveApp::m_maxSendBacklog),
+                                          MakeUintegerChecker<uint64_t>())
                             .AddTraceSource("Tx",
-                                            "A packet has been transmitted.",
+                                            "A payload has been completely written to the socket. "
+                                            "The packet has the size of the whole payload.",
                                             MakeTraceSourceAccessor(&IotPassiveApp::m_txTrace),
-                                            "ns3::Packet::TracedCallback")
+                                            "ns3::IotPassiveApp::TxTracedCallback")
+                            .AddTraceSource("TxChunk",
+                                            "A chunk of a payload (a datagram with UDP) has been written "
+                                            "to the socket.",
+                                            MakeTraceSourceAccessor(&IotPassiveApp::m_txChunkTrace),
+                                            "ns3::IotPassiveApp::TxTracedCallback")
                             .AddTraceSource("Rx",
                                             "A packet has been received.",
                                             MakeTraceSourceAccessor(&IotPassiveApp::m_rxTrace),
-                                            "ns3::Packet::PacketAddressTracedCallback");
+                                            "ns3::Packet::PacketAddressTracedCallback")
+                            .AddTraceSource("SendQueue",
+                                            "The send queue of a connection has changed.",
+                                            MakeTraceSourceAccessor(&IotPassiveApp::m_sendQueueTrace),
+                                            "ns3::IotPassiveApp::SendQueueTracedCallback")
+                            .AddTraceSource("Drop",
+                                            "A payload has been dropped because the send queue is full.",
+                                            MakeTraceSourceAccessor(&IotPassiveApp::m_dropTrace),
+                                            "ns3::IotPassiveApp::DropTracedCallback")
+                            .AddTraceSource("Modulation",
+                                            "A Markov-modulated sub-flow has entered a state.",
+                                            MakeTraceSourceAccessor(&IotPassiveApp::m_modulationTrace),
+                                            "ns3::IotPassiveApp::ModulationTracedCallback");
                             
     return tid;
 }
@@ -55,8 +158,11 @@ IotPassiveApp::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     StopApplication();
-    m_clientSockets.clear();
+    m_connections.clear();
+    m_freeSlots.clear();
     m_trafficProfile.clear();
+    m_modulations.clear();
+    m_modulationEvents.clear();
     Application::DoDispose();
 }
 
@@ -66,10 +172,13 @@ IotPassiveApp::StartApplication()
     NS_LOG_FUNCTION(this);
 
     if (!m_listeningSocket) {
-        m_listeningSocket = Socket::CreateSocket(GetNode(), TcpSocketFactory::GetTypeId());
+        m_listeningSocket = Socket::CreateSocket(GetNode(), m_tid);
+        m_datagram = m_listeningSocket->GetSocketType() == Socket::NS3_SOCK_DGRAM;
 
-        //define TCP segment size
-        m_listeningSocket->SetAttribute("SegmentSize", UintegerValue(1448));
+        if (!m_datagram) {
+            //define TCP segment size
+            m_listeningSocket->SetAttribute("SegmentSize", UintegerValue(1448));
+        }
         
         if (Ipv4Address::IsMatchingType(m_localAddress)) {
             InetSocketAddress local = InetSocketAddress(Ipv4Address::ConvertFrom(m_localAddress), m_localPort);
@@ -85,15 +194,17 @@ IotPassiveApp::StartApplication()
             NS_FATAL_ERROR("Unsupported address type.");
         }
 
-        m_listeningSocket->Listen();
-        m_listeningSocket->SetAcceptCallback(
-            MakeCallback(&IotPassiveApp::ConnectionRequestCallback, this),
-            MakeCallback(&IotPassiveApp::NewConnectionCreatedCallback, this));
-        m_listeningSocket->SetCloseCallbacks(
-            MakeCallback(&IotPassiveApp::ConnectionClosedCallback, this),
-            MakeNullCallback<void, Ptr<Socket>>());
+        if (m_datagram) {
+            m_listeningSocket->SetRecvCallback(MakeCallback(&IotPassiveApp::ReceivedDataCallback, this));
+        } else {
+            m_listeningSocket->Listen();
+            m_listeningSocket->SetAcceptCallback(
+                MakeCallback(&IotPassiveApp::ConnectionRequestCallback, this),
+                MakeCallback(&IotPassiveApp::NewConnectionCreatedCallback, this));
+        }
 
         m_state = AppState::STARTED;
+        StartModulation();
         NS_LOG_INFO("IoT application started, listening on port " << m_localPort);
     }
 }
@@ -109,24 +220,36 @@ IotPassiveApp::StopApplication()
         m_listeningSocket->Close();
         m_listeningSocket->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address&>(),
                                              MakeNullCallback<void, Ptr<Socket>, const Address&>());
+        m_listeningSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
         m_listeningSocket = nullptr;
     }
 
-    for (auto& entry : m_clientSockets) {
-        entry.first->Close();
-        entry.first->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    for (auto& connection : m_connections) {
+        if (!connection.socket) {
+            continue;
+        }
+        CancelEvents(connection);
+        if (m_datagram) {
+            // Subscribers share the listening socket, closed above
+            continue;
+        }
+        connection.socket->SetCloseCallbacks(MakeNullCallback<void, Ptr<Socket>>(),
+                                             MakeNullCallback<void, Ptr<Socket>>());
+        connection.socket->Close();
+        connection.socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        connection.socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
     }
-    m_clientSockets.clear();
+    m_connections.clear();
+    m_freeSlots.clear();
+    m_subscribers.clear();
+
+    Simulator::Cancel(m_sendTimer);
+    m_pendingSends.clear();
 
-    for (auto& entry : m_trafficProfileEvents) 
+    for (auto& event : m_modulationEvents)
     {
-        for (auto& event : entry.second) 
-        {
-            Simulator::Cancel(event);
-        }
+        Simulator::Cancel(event);
     }
-    m_trafficProfileEvents.clear();
-
 
     NS_LOG_INFO("IoT application stopped.");
 }
@@ -159,123 +282,252 @@ IotPassiveApp::SetTrafficProfile(const std::vector<std::shared_ptr<SubFlow>>& tr
 {
     NS_LOG_FUNCTION(this);
 
-    for (auto& entry : m_trafficProfileEvents) 
+    // Queued payloads refer to the previous profile and are discarded
+    for (auto& connection : m_connections) 
     {
-        for (auto& event : entry.second) 
-        {
-            Simulator::Cancel(event);
-        }
+        CancelEvents(connection);
+        connection.sendQueue.clear();
+        connection.backlogBytes = 0;
     }
-    m_trafficProfileEvents.clear();
 
-    
+    // The SubFlow objects may be shared with other applications, only the
+    // generator states, created with each connection, and the modulation
+    // states are owned by this one
     m_trafficProfile = trafficProfile;
+    m_modulations.clear();
+    m_modulations.resize(trafficProfile.size());
+    if (m_stream >= 0)
+    {
+        // Keep the streams assigned to the previous profile
+        NS_ABORT_MSG_IF(m_modulations.size() > m_modulationStreams,
+                        "The traffic profile has more sub-flows than the streams assigned by "
+                        "AssignStreams; set the profile first");
+        for (std::size_t i = 0; i < m_modulations.size(); ++i)
+        {
+            SubFlow::AssignStreams(m_modulations[i], m_stream + 1 + i);
+        }
+    }
+    if (m_state == AppState::STARTED)
+    {
+        StartModulation();
+    }
 
     NS_LOG_INFO("Traffic profile configured with " << trafficProfile.size() << " SubFlow objects.");
 }
 
+int64_t 
+IotPassiveApp::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+
+    NS_ABORT_MSG_IF(stream < 0 || stream >= (int64_t{1} << APP_STREAM_BITS),
+                    "IotPassiveApp streams must be between 0 and 2^" << APP_STREAM_BITS << " - 1");
+    m_stream = stream;
+    m_modulationStreams = m_modulations.size();
+    int64_t currentStream = stream + 1;
+    for (auto& modulation : m_modulations) 
+    {
+        currentStream += SubFlow::AssignStreams(modulation, currentStream);
+    }
+    return (currentStream - stream);
+}
 
-bool 
-IotPassiveApp::ConnectionRequestCallback(Ptr<Socket> socket, const Address &address) 
+void
+IotPassiveApp::StartModulation()
 {
-    NS_LOG_FUNCTION(this << socket << address);
-    if (InetSocketAddress::IsMatchingType(address))
+    NS_LOG_FUNCTION(this);
+
+    for (auto& event : m_modulationEvents)
     {
-        InetSocketAddress inetSocketAddress = InetSocketAddress::ConvertFrom(address);
-        Ipv4Address ipv4Address = inetSocketAddress.GetIpv4();
-        uint16_t port = inetSocketAddress.GetPort();
-        NS_LOG_INFO("Incoming connection request from " << ipv4Address
-                    << " port " << port);
+        Simulator::Cancel(event);
     }
-    else if (Ipv6Address::IsMatchingType(address))
+    m_modulationEvents.assign(m_trafficProfile.size(), EventId());
+
+    for (std::size_t i = 0; i < m_trafficProfile.size(); ++i)
     {
-        const Inet6SocketAddress inetSocket6Address = Inet6SocketAddress::ConvertFrom(address);
-        Ipv6Address ipv6Address = inetSocket6Address.GetIpv6();
-        uint16_t port = inetSocket6Address.GetPort();
-        NS_LOG_INFO("Incoming connection request from " << ipv6Address
-                    << " port " << port);
+        const std::shared_ptr<SubFlow>& subFlow = m_trafficProfile[i];
+        if (!subFlow || !subFlow->IsModulated())
+        {
+            continue;
+        }
+        double dwellTime = subFlow->StartModulation(m_modulations[i]);
+        m_modulationTrace(subFlow->GetId(), m_modulations[i].state);
+        m_modulationEvents[i] =
+            Simulator::Schedule(Seconds(dwellTime), &IotPassiveApp::ChangeModulationState, this, i);
     }
-    return true; // Accept all connections
+}
+
+void
+IotPassiveApp::ChangeModulationState(std::size_t subFlowIndex)
+{
+    NS_LOG_FUNCTION(this << subFlowIndex);
+
+    // The sends of every connection draw from the new state from now on
+    const std::shared_ptr<SubFlow>& subFlow = m_trafficProfile[subFlowIndex];
+    SubFlow::Modulation& modulation = m_modulations[subFlowIndex];
+    double dwellTime = subFlow->NextModulationState(modulation);
+    NS_LOG_INFO("SubFlow " << subFlow->GetId() << " entered state " << modulation.state
+                << " for " << dwellTime << " s");
+    m_modulationTrace(subFlow->GetId(), modulation.state);
+    m_modulationEvents[subFlowIndex] = Simulator::Schedule(Seconds(dwellTime),
+                                                           &IotPassiveApp::ChangeModulationState,
+                                                           this,
+                                                           subFlowIndex);
 }
 
 void 
-IotPassiveApp::NewConnectionCreatedCallback(Ptr<Socket> socket, const Address &address) 
+IotPassiveApp::CancelEvents(ClientConnection& connection)
 {
-    NS_LOG_FUNCTION(this << socket << address);
-    if (InetSocketAddress::IsMatchingType(address))
+    for (auto& subFlow : connection.subFlows) 
     {
-        InetSocketAddress inetSocketAddress = InetSocketAddress::ConvertFrom(address);
-        Ipv4Address ipv4Address = inetSocketAddress.GetIpv4();
-        uint16_t port = inetSocketAddress.GetPort();
-        NS_LOG_INFO("New connection established with " << ipv4Address
-                    << " port " << port);
+        Simulator::Cancel(subFlow.sendEvent);
     }
-    else if (Ipv6Address::IsMatchingType(address))
+    // Sends of the slot still in the local queue are skipped when popped
+    connection.generation++;
+}
+
+uint32_t 
+IotPassiveApp::AllocateSlot()
+{
+    if (!m_freeSlots.empty())
     {
-        const Inet6SocketAddress inetSocket6Address = Inet6SocketAddress::ConvertFrom(address);
-        Ipv6Address ipv6Address = inetSocket6Address.GetIpv6();
-        uint16_t port = inetSocket6Address.GetPort();
-        NS_LOG_INFO("New connection established with " << ipv6Address
-                    << " port " << port);
-    }    
+        uint32_t slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        return slot;
+    }
+    m_connections.emplace_back();
+    return static_cast<uint32_t>(m_connections.size() - 1);
+}
+
+void 
+IotPassiveApp::ReleaseSlot(uint32_t slot)
+{
+    ClientConnection& connection = m_connections[slot];
+    CancelEvents(connection);
+    connection.socket = nullptr;
+    connection.subFlows.clear();
+    connection.sendQueue.clear();
+    connection.backlogBytes = 0;
+    connection.tracedDepth = 0;
+    connection.tracedBacklog = 0;
+    m_freeSlots.push_back(slot);
+}
 
-    m_clientSockets[socket] = address;
+
+bool 
+IotPassiveApp::ConnectionRequestCallback(Ptr<Socket> socket, const Address &address) 
+{
+    NS_LOG_FUNCTION(this << socket << address);
+    NS_LOG_INFO("Incoming connection request from " << SocketAddressToString(address));
+    return true; // Accept all connections
+}
+
+void 
+IotPassiveApp::NewConnectionCreatedCallback(Ptr<Socket> socket, const Address &address) 
+{
+    NS_LOG_FUNCTION(this << socket << address);
+    NS_LOG_INFO("New connection established with " << SocketAddressToString(address));
+
+    uint32_t slot = AddConnection(socket, address);
 
     socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
-    socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
-    
-    for (auto& subFlow : m_trafficProfile) 
-    {
-        double interPacketInterval = subFlow->GetInterPacketTime();
-        EventId event = Simulator::Schedule(Seconds(interPacketInterval), &IotPassiveApp::SendData, this, socket, subFlow);
-        m_trafficProfileEvents[socket].push_back(event);
+    // The slot is bound to the callbacks so that they need no lookup.
+    socket->SetSendCallback(MakeCallback(&IotPassiveApp::SendCallback, this).Bind(slot));
+    socket->SetCloseCallbacks(
+        MakeCallback(&IotPassiveApp::ConnectionClosedCallback, this).Bind(slot),
+        MakeCallback(&IotPassiveApp::ConnectionClosedCallback, this).Bind(slot));
+}
 
+uint32_t 
+IotPassiveApp::AddConnection(Ptr<Socket> socket, const Address& address)
+{
+    uint32_t slot = AllocateSlot();
+    ClientConnection& connection = m_connections[slot];
+    connection.socket = socket;
+    // The peer address is cached once here and reused by every send
+    connection.address = address;
+    // Each SubFlow state is built separately, so that no two share a seed
+    connection.subFlows.clear();
+    connection.subFlows.resize(m_trafficProfile.size());
+
+    uint64_t ordinal = m_connectionCount++;
+    NS_ABORT_MSG_IF(m_stream >= 0 && ordinal >= (uint64_t{1} << CONNECTION_ORDINAL_BITS),
+                    "Too many connections for their random variable streams");
+    uint64_t subFlowStream = 0;
+    for (std::size_t i = 0; i < m_trafficProfile.size(); ++i) 
+    {
+        const std::shared_ptr<SubFlow>& subFlow = m_trafficProfile[i];
+        SubFlow::State& generators = connection.subFlows[i].generators;
+        if (m_stream >= 0)
+        {
+            // Deterministic stream: application stream, connection ordinal,
+            // then the streams taken by the previous sub-flows
+            uint64_t stream = CONNECTION_STREAM_FLAG |
+                              static_cast<uint64_t>(m_stream)
+                                  << (CONNECTION_ORDINAL_BITS + SUB_FLOW_STREAM_BITS) |
+                              ordinal << SUB_FLOW_STREAM_BITS | subFlowStream;
+            subFlowStream += subFlow->AssignStreams(generators, static_cast<int64_t>(stream));
+            NS_ABORT_MSG_IF(subFlowStream > (uint64_t{1} << SUB_FLOW_STREAM_BITS),
+                            "Too many sub-flow states for their random variable streams");
+        }
+        // The first delay reads the time preceding the first payload, so that
+        // replayed payload sizes keep the time recorded before them
+        double interPacketInterval =
+            subFlow->GetInterPacketTime(generators, m_modulations[i].state);
+        ScheduleSend(slot, i, Seconds(interPacketInterval));
     }
+    return slot;
 }
 
 void 
-IotPassiveApp::ConnectionClosedCallback(Ptr<Socket> socket) 
+IotPassiveApp::ReceivedDataCallback(Ptr<Socket> socket)
 {
     NS_LOG_FUNCTION(this << socket);
 
-    auto socketIt = m_clientSockets.find(socket);
-    if (socketIt != m_clientSockets.end()) {
-        if (InetSocketAddress::IsMatchingType(socketIt->second))
+    Ptr<Packet> packet;
+    Address from;
+    while ((packet = socket->RecvFrom(from)))
+    {
+        m_rxTrace(packet, from);
+        if (packet->GetSize() == 0)
         {
-            InetSocketAddress inetSocketAddress = InetSocketAddress::ConvertFrom(socketIt->second);
-            Ipv4Address ipv4Address = inetSocketAddress.GetIpv4();
-            uint16_t port = inetSocketAddress.GetPort();
-            NS_LOG_INFO("Connection with " << ipv4Address
-                        << " port " << port << " closed");
+            continue;
         }
-        else if (Ipv6Address::IsMatchingType(socketIt->second))
+
+        uint8_t control;
+        packet->CopyData(&control, 1);
+        auto it = m_subscribers.find(from);
+        if (control == static_cast<uint8_t>(IotUdpControl::SUBSCRIBE) && it == m_subscribers.end())
         {
-            const Inet6SocketAddress inetSocket6Address = Inet6SocketAddress::ConvertFrom(socketIt->second);
-            Ipv6Address ipv6Address = inetSocket6Address.GetIpv6();
-            uint16_t port = inetSocket6Address.GetPort();
-            NS_LOG_INFO("New connection established with " << ipv6Address
-                        << " port " << port << " closed");
-        }    
-        m_clientSockets.erase(socketIt);
-
-        auto eventIt = m_trafficProfileEvents.find(socket);
-        if (eventIt != m_trafficProfileEvents.end()) 
+            NS_LOG_INFO("New subscriber " << SocketAddressToString(from));
+            m_subscribers[from] = AddConnection(socket, from);
+        }
+        else if (control == static_cast<uint8_t>(IotUdpControl::UNSUBSCRIBE) && it != m_subscribers.end())
         {
-            for (auto& event : eventIt->second) 
-            {
-                Simulator::Cancel(event);
-            }
-            m_trafficProfileEvents.erase(eventIt); 
+            NS_LOG_INFO("Subscriber " << SocketAddressToString(from) << " left");
+            ReleaseSlot(it->second);
+            m_subscribers.erase(it);
         }
+    }
+}
+
+void 
+IotPassiveApp::ConnectionClosedCallback(uint32_t slot, Ptr<Socket> socket) 
+{
+    NS_LOG_FUNCTION(this << slot << socket);
 
+    if (slot < m_connections.size() && m_connections[slot].socket == socket) {
+        NS_LOG_INFO("Connection with " << SocketAddressToString(m_connections[slot].address)
+                    << " closed");
+        ReleaseSlot(slot);
     }
 }
 
 
 void 
-IotPassiveApp::SendData(Ptr<Socket> socket, std::shared_ptr<SubFlow> subFlow)
+IotPassiveApp::SendData(uint32_t slot, std::size_t subFlowIndex)
 {
-    NS_LOG_FUNCTION(this << socket << subFlow);
+    NS_LOG_FUNCTION(this << slot << subFlowIndex);
 
     if (m_state != AppState::STARTED) 
     {
@@ -283,51 +535,208 @@ IotPassiveApp::SendData(Ptr<Socket> socket, std::shared_ptr<SubFlow> subFlow)
         return;
     }
 
+    Ptr<Socket> socket = m_connections[slot].socket;
+    if (!socket)
+    {
+        NS_LOG_WARN("SendPacketForClass invoked for a connection that is closed.");
+        return;
+    }
+
+    const std::shared_ptr<SubFlow>& subFlow = m_trafficProfile[subFlowIndex];
     if (!subFlow)
     {
         NS_LOG_ERROR("SendPacketForClass received a null SubFlow pointer.");
         return;
     }
 
-    uint32_t packetSize = subFlow->GetPayloadSize();
-    double interPacketInterval = subFlow->GetInterPacketTime();
+    // Payload size and time to the next packet, correlated for joint sub-flows
+    ClientConnection& connection = m_connections[slot];
+    SubFlow::NextPacket next = subFlow->GetNextPacket(connection.subFlows[subFlowIndex].generators,
+                                                      m_modulations[subFlowIndex].state);
+    uint32_t packetSize = next.payloadSize;
+    double interPacketInterval = next.interPacketTime;
+
+    if (m_maxSendBacklog > 0 && connection.backlogBytes + packetSize > m_maxSendBacklog)
+    {
+        NS_LOG_WARN("Send backlog to " << SocketAddressToString(connection.address)
+                    << " is full, dropping " << packetSize << " bytes.");
+        m_dropTrace(connection.address, packetSize, subFlow->GetId());
+    }
+    else if (packetSize > 0)
+    {
+        connection.sendQueue.push_back({packetSize, packetSize, static_cast<uint16_t>(subFlowIndex)});
+        connection.backlogBytes += packetSize;
+        FlushSendQueue(slot);
+
+        // Sending may close the connection and release its slot.
+        if (m_connections[slot].socket != socket)
+        {
+            return;
+        }
+    }
+
+    ScheduleSend(slot, subFlowIndex, Seconds(interPacketInterval));
+}
 
-    Ptr<Packet> packet = Create<Packet>(packetSize);
-    int bytesSent = socket->Send(packet);
+void 
+IotPassiveApp::FlushSendQueue(uint32_t slot)
+{
+    NS_LOG_FUNCTION(this << slot);
 
-    if (bytesSent > 0)
+    Ptr<Socket> socket = m_connections[slot].socket;
+    while (!m_connections[slot].sendQueue.empty())
     {
-        Address clientAddress;
-        socket->GetPeerName(clientAddress);
-        if (InetSocketAddress::IsMatchingType(clientAddress))
+        uint32_t available = socket->GetTxAvailable();
+        if (available == 0)
+        {
+            // Resumed by SendCallback once the socket frees buffer space
+            break;
+        }
+
+        uint32_t chunkSize = std::min(m_connections[slot].sendQueue.front().remaining, available);
+        Ptr<Packet> packet;
+        int bytesSent;
+        if (m_datagram)
+        {
+            // One datagram per chunk, all subscribers share the socket
+            chunkSize = std::min(chunkSize, m_maxDatagramSize);
+            packet = Create<Packet>(chunkSize);
+            bytesSent = socket->SendTo(packet, 0, m_connections[slot].address);
+        }
+        else
         {
-            InetSocketAddress inetSocketAddress = InetSocketAddress::ConvertFrom(clientAddress);
-            Ipv4Address ipv4Address = inetSocketAddress.GetIpv4();
-            uint16_t port = inetSocketAddress.GetPort();
+            packet = Create<Packet>(chunkSize);
+            bytesSent = socket->Send(packet);
+        }
+
+        // Sending may close the connection and release its slot.
+        ClientConnection& connection = m_connections[slot];
+        if (connection.socket != socket)
+        {
+            return;
+        }
+        if (bytesSent <= 0)
+        {
+            NS_LOG_ERROR("Failed to send packet. Socket error: " << socket->GetErrno());
+            break;
+        }
+
+        QueuedPayload& payload = connection.sendQueue.front();
+        SubFlowState& state = connection.subFlows[payload.subFlowIndex];
+        state.txBytes += bytesSent;
+        payload.remaining -= bytesSent;
+        connection.backlogBytes -= bytesSent;
+
+        // Formatting only happens when the log component is enabled
+        NS_LOG_INFO("Sent " << bytesSent << " bytes to " << SocketAddressToString(connection.address));
+        if (!m_txChunkTrace.IsEmpty())
+        {
+            m_txChunkTrace(packet, connection.address, m_trafficProfile[payload.subFlowIndex]->GetId());
+        }
 
-            NS_LOG_INFO("Sent " << packetSize
-                      << " bytes to " << ipv4Address
-                      << " port " << port);
+        if (payload.remaining == 0)
+        {
+            // One Tx per payload, whatever the number of chunks it took
+            if (!m_txTrace.IsEmpty())
+            {
+                m_txTrace(Create<Packet>(payload.size),
+                          connection.address,
+                          m_trafficProfile[payload.subFlowIndex]->GetId());
+            }
+            state.txPackets++;
+            connection.sendQueue.pop_front();
         }
-        else if (Ipv6Address::IsMatchingType(clientAddress))
+    }
+
+    // Report the queue only when it differs from the last report, not on
+    // every SendCallback
+    ClientConnection& connection = m_connections[slot];
+    uint32_t depth = connection.sendQueue.size();
+    if (depth != connection.tracedDepth || connection.backlogBytes != connection.tracedBacklog)
+    {
+        connection.tracedDepth = depth;
+        connection.tracedBacklog = connection.backlogBytes;
+        m_sendQueueTrace(connection.address, depth, connection.backlogBytes);
+    }
+}
+
+void 
+IotPassiveApp::SendCallback(uint32_t slot, Ptr<Socket> socket, uint32_t available)
+{
+    NS_LOG_FUNCTION(this << slot << socket << available);
+
+    if (slot < m_connections.size() && m_connections[slot].socket == socket)
+    {
+        FlushSendQueue(slot);
+    }
+}
+
+void 
+IotPassiveApp::ScheduleSend(uint32_t slot, std::size_t subFlowIndex, Time delay)
+{
+    if (!m_multiplexSends)
+    {
+        // Replace the expired event in place: one pending event per sub-flow.
+        m_connections[slot].subFlows[subFlowIndex].sendEvent =
+            Simulator::Schedule(delay, &IotPassiveApp::SendData, this, slot, subFlowIndex);
+        return;
+    }
+
+    PendingSend send;
+    send.deadline = Simulator::Now() + delay;
+    send.sequence = m_pendingSendSequence++;
+    send.slot = slot;
+    send.generation = m_connections[slot].generation;
+    send.subFlowIndex = static_cast<uint16_t>(subFlowIndex);
+    m_pendingSends.push_back(send);
+    std::push_heap(m_pendingSends.begin(), m_pendingSends.end(), std::greater<PendingSend>());
+
+    if (!m_draining)
+    {
+        UpdateSendTimer();
+    }
+}
+
+void 
+IotPassiveApp::DrainPendingSends()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_draining = true;
+    Time now = Simulator::Now();
+    while (!m_pendingSends.empty() && m_pendingSends.front().deadline <= now)
+    {
+        std::pop_heap(m_pendingSends.begin(), m_pendingSends.end(), std::greater<PendingSend>());
+        PendingSend send = m_pendingSends.back();
+        m_pendingSends.pop_back();
+
+        // Sends queued before the connection was closed or the profile changed
+        if (send.slot < m_connections.size() && m_connections[send.slot].generation == send.generation)
         {
-            const Inet6SocketAddress inetSocket6Address = Inet6SocketAddress::ConvertFrom(clientAddress);
-            Ipv6Address ipv6Address = inetSocket6Address.GetIpv6();
-            uint16_t port = inetSocket6Address.GetPort();
-            
-            NS_LOG_INFO("Sent " << packetSize
-                      << " bytes to " << ipv6Address
-                      << " port " << port);
+            SendData(send.slot, send.subFlowIndex);
         }
-        m_txTrace(packet, clientAddress, subFlow->GetId());
     }
-    else
+    m_draining = false;
+    UpdateSendTimer();
+}
+
+void 
+IotPassiveApp::UpdateSendTimer()
+{
+    if (m_pendingSends.empty())
     {
-        NS_LOG_ERROR("Failed to send packet. Socket error: " << socket->GetErrno());
+        Simulator::Cancel(m_sendTimer);
+        return;
     }
 
-    EventId nextEvent = Simulator::Schedule(Seconds(interPacketInterval), &IotPassiveApp::SendData, this, socket, subFlow);
-    m_trafficProfileEvents[socket].push_back(nextEvent);
+    Time deadline = m_pendingSends.front().deadline;
+    if (!m_sendTimer.IsExpired() && m_sendTimerDeadline <= deadline)
+    {
+        return;
+    }
+    Simulator::Cancel(m_sendTimer);
+    m_sendTimerDeadline = deadline;
+    m_sendTimer = Simulator::Schedule(deadline - Simulator::Now(), &IotPassiveApp::DrainPendingSends, this);
 }
 
 
@@ -1,6 +1,7 @@
 #ifndef IOT_PASSIVE_APP
 #define IOT_PASSIVE_APP
 
+#include <deque>
 #include <map>
 #include <string>
 #include <vector>
@@ -25,11 +26,43 @@ enum class AppState
     STARTED
 };
 
+/**
+ * First byte of the control datagrams sent by an IotClient to an
+ * IotPassiveApp when the UDP protocol is used.
+ */
+enum class IotUdpControl : uint8_t
+{
+    UNSUBSCRIBE = 0,
+    SUBSCRIBE = 1
+};
+
 /**
  * \brief Iot Camera Application capable of handling multiple clients.
  *
  * This application passively listens for incoming TCP connections and can handle
  * multiple clients simultaneously.
+ *
+ * With the UDP protocol, a client registers by sending a SUBSCRIBE datagram
+ * (see IotUdpControl) and the traffic is streamed to the address it came
+ * from, payloads larger than MaxDatagramSize being split into datagrams,
+ * until an UNSUBSCRIBE datagram is received.
+ *
+ * By default every sub-flow of every connection keeps its own pending simulator
+ * event. With the MultiplexSends attribute, the application instead keeps its
+ * sends in a local min-heap and holds a single simulator event, set at the
+ * earliest deadline, which sends every packet that is due when it fires.
+ *
+ * Payloads are written as the socket accepts them, possibly in several
+ * chunks (or datagrams). The Tx trace fires once per payload, with its full
+ * size, when its last chunk is written; the TxChunk trace fires for every
+ * chunk.
+ *
+ * Every connection draws its payload sizes and inter-packet times from its
+ * own generator states, so that replayed sequences are read in order by
+ * each client. Markov-modulated sub-flows are in one state for all the
+ * connections of the application, and each state change costs a single
+ * simulator event. Sends already scheduled keep the inter-packet time drawn
+ * in the previous state.
  */
 class IotPassiveApp : public Application
 {
@@ -50,6 +83,37 @@ public:
      */
     static TypeId GetTypeId();
 
+    /**
+     * TracedCallback signature for transmitted payloads and chunks.
+     * \param packet A packet of the size of the payload or of the chunk.
+     * \param address Address of the remote client.
+     * \param subFlowId Identifier of the SubFlow of the payload.
+     */
+    typedef void (*TxTracedCallback)(Ptr<const Packet> packet, const Address& address, uint16_t subFlowId);
+
+    /**
+     * TracedCallback signature for send queue changes.
+     * \param address Address of the remote client.
+     * \param depth Number of payloads waiting, including a partially sent one.
+     * \param backlog Number of bytes waiting to be written to the socket.
+     */
+    typedef void (*SendQueueTracedCallback)(const Address& address, uint32_t depth, uint64_t backlog);
+
+    /**
+     * TracedCallback signature for dropped payloads.
+     * \param address Address of the remote client.
+     * \param size Size of the dropped payload, in bytes.
+     * \param subFlowId Identifier of the SubFlow of the payload.
+     */
+    typedef void (*DropTracedCallback)(const Address& address, uint32_t size, uint16_t subFlowId);
+
+    /**
+     * TracedCallback signature for state changes of Markov-modulated SubFlow objects.
+     * \param subFlowId Identifier of the SubFlow.
+     * \param state Index of the state entered.
+     */
+    typedef void (*ModulationTracedCallback)(uint16_t subFlowId, uint32_t state);
+
     /**
      * Returns the current state of the application in string format.
      * \return The current state of the application in string format.
@@ -65,15 +129,83 @@ public:
     /**
      * Set the traffic profile using a list of SubFlow objects.
      * This function replaces any existing packet classes with the provided list.
+     * The SubFlow objects are not modified and can be shared between
+     * applications: each connection draws from its own generator states.
      * 
      * \param subFlowes A vector of shared pointers to SubFlow objects.
      */
     void SetTrafficProfile(const std::vector<std::shared_ptr<SubFlow>>& trafficProfile);
 
+    /**
+     * Assign fixed random variable streams to the application. The first
+     * stream keys the streams of the generator states of the connections
+     * accepted from now on: each is derived from it, the ordinal of the
+     * connection and the SubFlow index, in a range of its own which no
+     * other application or connection uses. The next ones seed the state
+     * changes of the Markov-modulated sub-flows. Must be called after
+     * SetTrafficProfile; a later SetTrafficProfile keeps these streams, and
+     * aborts if the new profile has more sub-flows than streams assigned.
+     *
+     * \param stream First stream index to use, lower than 2^22.
+     * \return The number of stream indices assigned: one, plus one per SubFlow.
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
 protected:
     void DoDispose() override;
 
 private:
+    /// State kept for each SubFlow of a connection.
+    struct SubFlowState
+    {
+        EventId sendEvent;         ///< Pending send event of the SubFlow.
+        SubFlow::State generators; ///< Generator states of the SubFlow for the connection.
+        uint64_t txPackets{0};     ///< Number of packets sent for the SubFlow.
+        uint64_t txBytes{0};       ///< Number of bytes sent for the SubFlow.
+    };
+
+    /// Payload waiting in the send queue of a connection.
+    struct QueuedPayload
+    {
+        uint32_t size;         ///< Size of the payload, reported by the Tx trace.
+        uint32_t remaining;    ///< Bytes not yet written to the socket.
+        uint16_t subFlowIndex; ///< Index of the SubFlow in the traffic profile.
+    };
+
+    /// Slot of the connection table, holding the state of one accepted connection.
+    struct ClientConnection
+    {
+        Ptr<Socket> socket;                 ///< Connected socket, null when the slot is free.
+        Address address;                    ///< Address of the remote client.
+        std::vector<SubFlowState> subFlows; ///< SubFlow state, indexed like the traffic profile.
+        uint32_t generation{0};             ///< Bumped to invalidate queued sends of the slot.
+        std::deque<QueuedPayload> sendQueue; ///< Payloads not fully written to the socket yet.
+        uint64_t backlogBytes{0};           ///< Bytes waiting in sendQueue.
+        uint32_t tracedDepth{0};            ///< Depth last reported by the SendQueue trace.
+        uint64_t tracedBacklog{0};          ///< Backlog last reported by the SendQueue trace.
+    };
+
+    /// Send waiting in the local queue when sends are multiplexed.
+    struct PendingSend
+    {
+        Time deadline;         ///< Time at which the packet is sent.
+        uint64_t sequence;     ///< Insertion order, breaks ties between equal deadlines.
+        uint32_t slot;         ///< Index of the connection in the connection table.
+        uint32_t generation;   ///< Generation of the slot when the send was queued.
+        uint16_t subFlowIndex; ///< Index of the SubFlow in the traffic profile.
+
+        /**
+         * Order sends by deadline then insertion order, for a min-heap.
+         * \param other The send to compare with.
+         * \return true if this send is due after \p other.
+         */
+        bool operator>(const PendingSend& other) const
+        {
+            return deadline > other.deadline ||
+                   (deadline == other.deadline && sequence > other.sequence);
+        }
+    };
+
     void StartApplication() override;
     void StopApplication() override;
     // SOCKET CALLBACK METHODS
@@ -95,38 +227,153 @@ private:
      */
     void NewConnectionCreatedCallback(Ptr<Socket> socket, const Address& address);
 
+    /**
+     * Invoked when the UDP socket receives a control datagram.
+     * \param socket Pointer to the socket where the event originates from.
+     */
+    void ReceivedDataCallback(Ptr<Socket> socket);
+
+    /**
+     * Add a client to the connection table and start its sub-flows.
+     * \param socket The socket used to send to the client.
+     * \param address The address of the remote client.
+     * \return The slot of the client in the connection table.
+     */
+    uint32_t AddConnection(Ptr<Socket> socket, const Address& address);
+
     /**
      * Invoked when a connection with a client is terminated.
+     * \param slot Index of the connection in the connection table.
      * \param socket Pointer to the socket where the event originates from.
      */
-    void ConnectionClosedCallback(Ptr<Socket> socket);
+    void ConnectionClosedCallback(uint32_t slot, Ptr<Socket> socket);
 
     /**
      * Send video data.
-     * \param socket Pointer to the socket to send data.
-     * \param subFlow Packet class associated.
+     * \param slot Index of the connection in the connection table.
+     * \param subFlowIndex Index of the associated SubFlow in the traffic profile.
+     */
+    void SendData(uint32_t slot, std::size_t subFlowIndex);
+
+    /**
+     * Write as much of the send queue of a connection as the socket
+     * transmit buffer accepts, splitting payloads if needed.
+     * \param slot Index of the connection in the connection table.
+     */
+    void FlushSendQueue(uint32_t slot);
+
+    /**
+     * Invoked when the socket has freed transmit buffer space.
+     * \param slot Index of the connection in the connection table.
+     * \param socket Pointer to the socket where the event originates from.
+     * \param available Number of bytes available in the transmit buffer.
+     */
+    void SendCallback(uint32_t slot, Ptr<Socket> socket, uint32_t available);
+
+    /**
+     * Schedule the next packet of a SubFlow, either as its own simulator
+     * event or in the local queue when sends are multiplexed.
+     * \param slot Index of the connection in the connection table.
+     * \param subFlowIndex Index of the SubFlow in the traffic profile.
+     * \param delay Delay until the packet is sent.
+     */
+    void ScheduleSend(uint32_t slot, std::size_t subFlowIndex, Time delay);
+
+    /**
+     * Send every packet of the local queue that is due, then schedule the
+     * single simulator event at the next deadline.
+     */
+    void DrainPendingSends();
+
+    /**
+     * Make the simulator event of the local queue fire at its earliest deadline.
      */
-    void SendData(Ptr<Socket> socket, std::shared_ptr<SubFlow> subFlow);
+    void UpdateSendTimer();
 
-    /// List of SubFlow objects (abstract or derived)
+    /**
+     * Put every Markov-modulated SubFlow in its first state and schedule
+     * its first state change, cancelling the pending ones.
+     */
+    void StartModulation();
+
+    /**
+     * Move a Markov-modulated SubFlow to its next state and schedule the
+     * following state change.
+     * \param subFlowIndex Index of the SubFlow in the traffic profile.
+     */
+    void ChangeModulationState(std::size_t subFlowIndex);
+
+    /**
+     * Reserve a slot of the connection table, reusing a released one if any.
+     * \return The index of the reserved slot.
+     */
+    uint32_t AllocateSlot();
+
+    /**
+     * Cancel the events of a connection and return its slot to the free list.
+     * \param slot Index of the connection in the connection table.
+     */
+    void ReleaseSlot(uint32_t slot);
+
+    /**
+     * Cancel every pending send event of a connection.
+     * \param connection The connection whose events are cancelled.
+     */
+    static void CancelEvents(ClientConnection& connection);
+
+    /// List of SubFlow objects (abstract or derived), possibly shared with other applications
     std::vector<std::shared_ptr<SubFlow>> m_trafficProfile;
+    /// Current state of each Markov-modulated SubFlow, indexed like the traffic profile.
+    std::vector<SubFlow::Modulation> m_modulations;
+    /// First stream given to AssignStreams, -1 until then.
+    int64_t m_stream{-1};
+    /// Number of modulation streams assigned after m_stream.
+    std::size_t m_modulationStreams{0};
+    /// Number of connections added so far, the ordinal of the next one.
+    uint64_t m_connectionCount{0};
+    /// Pending state change of each Markov-modulated SubFlow, indexed like the traffic profile.
+    std::vector<EventId> m_modulationEvents;
 
-    std::map<Ptr<Socket>, std::vector<EventId>> m_trafficProfileEvents;
     /// The listening socket for receiving connection requests from clients.
     Ptr<Socket> m_listeningSocket;
-    /// Collection of accepted sockets.
-    std::map<Ptr<Socket>, Address> m_clientSockets;
+    /// Connection table, indexed by the slot bound to each socket callback.
+    std::vector<ClientConnection> m_connections;
+    /// Released slots of the connection table, reused by new connections.
+    std::vector<uint32_t> m_freeSlots;
+    /// Slot of each UDP subscriber, by address.
+    std::map<Address, uint32_t> m_subscribers;
+    /// True if the socket is a datagram (UDP) socket.
+    bool m_datagram{false};
+
+    /// Local queue of sends (min-heap on deadline) when sends are multiplexed.
+    std::vector<PendingSend> m_pendingSends;
+    /// Number of sends queued so far, used as tie-breaker.
+    uint64_t m_pendingSendSequence{0};
+    /// The single simulator event draining the local queue.
+    EventId m_sendTimer;
+    /// Deadline of m_sendTimer.
+    Time m_sendTimerDeadline;
+    /// True while the local queue is being drained.
+    bool m_draining{false};
     /// The state of the application.
     AppState m_state;
 
     // ATTRIBUTES
     Address m_localAddress; ///< The local address to bind the socket to.
     uint16_t m_localPort;   ///< The local port to bind the socket to.
+    TypeId m_tid;           ///< The type of protocol to use.
+    bool m_multiplexSends;  ///< Schedule all sends from a local queue with one simulator event.
+    uint64_t m_maxSendBacklog; ///< Maximum bytes queued per connection, 0 for unlimited.
+    uint32_t m_maxDatagramSize; ///< Maximum payload of a UDP datagram.
 
     // TRACE SOURCES
     TracedCallback<Ptr<Socket>, const Address&> m_newConnectionTrace; ///< Trace for new connections.
     TracedCallback<Ptr<const Packet>, const Address&> m_rxTrace;      ///< Trace for received packets.
-    TracedCallback<Ptr<const Packet>, const Address&, uint16_t> m_txTrace; ///< Trace for transmitted packets.
+    TracedCallback<Ptr<const Packet>, const Address&, uint16_t> m_txTrace; ///< Trace for transmitted payloads.
+    TracedCallback<Ptr<const Packet>, const Address&, uint16_t> m_txChunkTrace; ///< Trace for transmitted chunks.
+    TracedCallback<const Address&, uint32_t, uint64_t> m_sendQueueTrace;  ///< Trace for send queue changes.
+    TracedCallback<const Address&, uint32_t, uint16_t> m_dropTrace;       ///< Trace for dropped payloads.
+    TracedCallback<uint16_t, uint32_t> m_modulationTrace;                 ///< Trace for state changes.
 };
 
 } // namespace ns3
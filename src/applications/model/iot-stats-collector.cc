@@ -0,0 +1,280 @@
+#include "iot-stats-collector.h"
+
+#include "iot-client.h"
+#include "iot-passive-app.h"
+
+#include <ns3/abort.h>
+#include <ns3/log.h>
+#include <ns3/node.h>
+#include <ns3/packet.h>
+#include <ns3/simulator.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+NS_LOG_COMPONENT_DEFINE("IotStatsCollector");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(IotStatsCollector);
+
+namespace
+{
+
+/**
+ * Write the running statistics and the histogram of a quantity as JSON.
+ * \param os The output stream.
+ * \param stats The running statistics.
+ * \param histogram The histogram.
+ */
+void
+PrintQuantity(std::ostream& os,
+              const IotStatsCollector::RunningStats& stats,
+              const IotStatsCollector::LogHistogram& histogram)
+{
+    os << "{\"count\":" << stats.GetCount() << ",\"mean\":" << stats.GetMean()
+       << ",\"variance\":" << stats.GetVariance() << ",\"min\":" << stats.GetMin()
+       << ",\"max\":" << stats.GetMax() << ",\"histogram\":";
+    histogram.Print(os);
+    os << "}";
+}
+
+} // namespace
+
+void
+IotStatsCollector::RunningStats::Add(double value)
+{
+    if (m_count == 0)
+    {
+        m_min = value;
+        m_max = value;
+    }
+    else
+    {
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    m_count++;
+    double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+}
+
+uint64_t
+IotStatsCollector::RunningStats::GetCount() const
+{
+    return m_count;
+}
+
+double
+IotStatsCollector::RunningStats::GetMean() const
+{
+    return m_mean;
+}
+
+double
+IotStatsCollector::RunningStats::GetVariance() const
+{
+    return m_count > 1 ? m_m2 / (m_count - 1) : 0;
+}
+
+double
+IotStatsCollector::RunningStats::GetMin() const
+{
+    return m_min;
+}
+
+double
+IotStatsCollector::RunningStats::GetMax() const
+{
+    return m_max;
+}
+
+void
+IotStatsCollector::LogHistogram::Add(double value)
+{
+    if (value <= 0)
+    {
+        m_nonPositive++;
+        return;
+    }
+    auto bucket = static_cast<int32_t>(std::floor(std::log2(value) * BUCKETS_PER_OCTAVE));
+    m_buckets[bucket]++;
+}
+
+void
+IotStatsCollector::LogHistogram::Print(std::ostream& os) const
+{
+    os << "[";
+    bool first = true;
+    if (m_nonPositive > 0)
+    {
+        os << "[0," << m_nonPositive << "]";
+        first = false;
+    }
+    for (const auto& [bucket, count] : m_buckets)
+    {
+        if (!first)
+        {
+            os << ",";
+        }
+        os << "[" << std::exp2(static_cast<double>(bucket) / BUCKETS_PER_OCTAVE) << "," << count
+           << "]";
+        first = false;
+    }
+    os << "]";
+}
+
+TypeId
+IotStatsCollector::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::IotStatsCollector")
+                            .SetParent<Object>()
+                            .AddConstructor<IotStatsCollector>()
+                            .AddAttribute("ThroughputInterval",
+                                          "Width of the bins of the throughput time series. "
+                                          "A zero value disables the time series.",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&IotStatsCollector::m_throughputInterval),
+                                          MakeTimeChecker(Time(0)));
+    return tid;
+}
+
+IotStatsCollector::IotStatsCollector()
+    : m_throughputInterval(Seconds(1))
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+IotStatsCollector::Attach(ApplicationContainer apps)
+{
+    NS_LOG_FUNCTION(this);
+
+    for (auto it = apps.Begin(); it != apps.End(); ++it)
+    {
+        uint32_t nodeId = (*it)->GetNode()->GetId();
+        if (DynamicCast<IotPassiveApp>(*it))
+        {
+            (*it)->TraceConnectWithoutContext("Tx",
+                                              MakeCallback(&IotStatsCollector::CollectTx, this).Bind(nodeId));
+        }
+        else if (DynamicCast<IotClient>(*it))
+        {
+            (*it)->TraceConnectWithoutContext("Rx",
+                                              MakeCallback(&IotStatsCollector::CollectRx, this).Bind(nodeId));
+        }
+    }
+}
+
+const IotStatsCollector::FlowStats*
+IotStatsCollector::GetFlowStats(uint32_t nodeId, bool tx, uint16_t subFlowId) const
+{
+    auto it = m_flows.find(MakeKey(nodeId, tx, subFlowId));
+    return it == m_flows.end() ? nullptr : &it->second;
+}
+
+void
+IotStatsCollector::ForEachFlow(
+    const std::function<void(uint32_t, bool, uint16_t, const FlowStats&)>& function) const
+{
+    for (const auto& [key, stats] : m_flows)
+    {
+        function(static_cast<uint32_t>(key >> 32), (key >> 16) & 1, key & 0xffff, stats);
+    }
+}
+
+void
+IotStatsCollector::WriteSummary(const std::string& filename) const
+{
+    NS_LOG_FUNCTION(this << filename);
+
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    NS_ABORT_MSG_IF(!out.is_open(), "Unable to open the file " << filename);
+    out.precision(std::numeric_limits<double>::max_digits10);
+
+    out << "{\"throughputInterval\":" << m_throughputInterval.GetSeconds() << ",\"flows\":[";
+    bool first = true;
+    for (const auto& [key, stats] : m_flows)
+    {
+        if (!first)
+        {
+            out << ",";
+        }
+        first = false;
+
+        out << "\n{\"node\":" << (key >> 32) << ",\"direction\":\""
+            << ((key >> 16) & 1 ? "Tx" : "Rx") << "\",\"subFlow\":" << (key & 0xffff)
+            << ",\"packets\":" << stats.sizes.GetCount() << ",\"bytes\":" << stats.bytes
+            << ",\"first\":" << stats.firstPacket.GetSeconds()
+            << ",\"last\":" << stats.lastPacket.GetSeconds() << ",\"size\":";
+        PrintQuantity(out, stats.sizes, stats.sizeHistogram);
+        out << ",\"interval\":";
+        PrintQuantity(out, stats.intervals, stats.intervalHistogram);
+        out << ",\"throughput\":[";
+        for (std::size_t i = 0; i < stats.throughput.size(); i++)
+        {
+            out << (i ? "," : "") << stats.throughput[i];
+        }
+        out << "]}";
+    }
+    out << "\n]}\n";
+}
+
+uint64_t
+IotStatsCollector::MakeKey(uint32_t nodeId, bool tx, uint16_t subFlowId)
+{
+    return (static_cast<uint64_t>(nodeId) << 32) | (static_cast<uint64_t>(tx) << 16) | subFlowId;
+}
+
+void
+IotStatsCollector::CollectTx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address, uint16_t subFlowId)
+{
+    Collect(MakeKey(nodeId, true, subFlowId), address, packet->GetSize());
+}
+
+void
+IotStatsCollector::CollectRx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address)
+{
+    Collect(MakeKey(nodeId, false, 0), address, packet->GetSize());
+}
+
+void
+IotStatsCollector::Collect(uint64_t key, const Address& peer, uint32_t size)
+{
+    Time now = Simulator::Now();
+    FlowStats& stats = m_flows[key];
+
+    if (stats.sizes.GetCount() == 0)
+    {
+        stats.firstPacket = now;
+    }
+    stats.lastPacket = now;
+
+    auto [last, inserted] = stats.lastPacketByPeer.emplace(peer, now);
+    if (!inserted)
+    {
+        double interval = (now - last->second).GetSeconds();
+        stats.intervals.Add(interval);
+        stats.intervalHistogram.Add(interval);
+        last->second = now;
+    }
+
+    stats.bytes += size;
+    stats.sizes.Add(size);
+    stats.sizeHistogram.Add(size);
+
+    if (m_throughputInterval.IsStrictlyPositive())
+    {
+        auto bin = static_cast<std::size_t>(now.GetTimeStep() / m_throughputInterval.GetTimeStep());
+        if (bin >= stats.throughput.size())
+        {
+            stats.throughput.resize(bin + 1, 0);
+        }
+        stats.throughput[bin] += size;
+    }
+}
+
+} // namespace ns3
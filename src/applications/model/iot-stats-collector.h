@@ -0,0 +1,195 @@
+#ifndef IOT_STATS_COLLECTOR_H
+#define IOT_STATS_COLLECTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <ns3/address.h>
+#include <ns3/application-container.h>
+#include <ns3/nstime.h>
+#include <ns3/object.h>
+#include <ns3/ptr.h>
+
+namespace ns3
+{
+
+class Packet;
+
+/**
+ * \ingroup applications
+ * Online statistics of the packets sent by IotPassiveApp and received by
+ * IotClient applications.
+ *
+ * Instead of storing packets, the collector keeps streaming statistics per
+ * node, direction and sub-flow: packet and byte counters, mean and variance
+ * (Welford) of sizes and inter-packet intervals, log-bucketed histograms of
+ * both, and the bytes sent or received per ThroughputInterval. Received
+ * packets carry no sub-flow id and are accounted under sub-flow 0.
+ *
+ * Inter-packet intervals are measured between consecutive packets of the
+ * same peer (the client for Tx, the camera for Rx), then merged in the
+ * statistics of the flow, so that the clients sharing a node do not
+ * shorten each other's intervals.
+ */
+class IotStatsCollector : public Object
+{
+public:
+    /// Mean, variance and range of a sample, updated one value at a time.
+    class RunningStats
+    {
+    public:
+        /**
+         * Add a value (Welford's algorithm).
+         * \param value The value.
+         */
+        void Add(double value);
+
+        /// \return The number of values added.
+        uint64_t GetCount() const;
+        /// \return The mean of the values.
+        double GetMean() const;
+        /// \return The unbiased variance of the values.
+        double GetVariance() const;
+        /// \return The smallest value.
+        double GetMin() const;
+        /// \return The largest value.
+        double GetMax() const;
+
+    private:
+        uint64_t m_count{0}; ///< Number of values.
+        double m_mean{0};    ///< Running mean.
+        double m_m2{0};      ///< Sum of squared differences to the mean.
+        double m_min{0};     ///< Smallest value.
+        double m_max{0};     ///< Largest value.
+    };
+
+    /**
+     * Histogram with logarithmic buckets: BUCKETS_PER_OCTAVE buckets per
+     * power of two, only non-empty buckets being stored.
+     */
+    class LogHistogram
+    {
+    public:
+        /// Number of buckets between two consecutive powers of two.
+        static constexpr int BUCKETS_PER_OCTAVE = 4;
+
+        /**
+         * Count a value. Values <= 0 share a dedicated bucket.
+         * \param value The value.
+         */
+        void Add(double value);
+
+        /**
+         * Write the histogram as a JSON array of [lower bound, count] pairs.
+         * \param os The output stream.
+         */
+        void Print(std::ostream& os) const;
+
+    private:
+        uint64_t m_nonPositive{0};         ///< Number of values <= 0.
+        std::map<int32_t, uint64_t> m_buckets; ///< Count of each non-empty bucket.
+    };
+
+    /**
+     * Statistics of one node, direction and sub-flow. The packet count is
+     * sizes.GetCount().
+     */
+    struct FlowStats
+    {
+        uint64_t bytes{0};               ///< Total bytes.
+        Time firstPacket;                ///< Time of the first packet.
+        Time lastPacket;                 ///< Time of the last packet.
+        RunningStats sizes;              ///< Packet sizes, in bytes.
+        RunningStats intervals;          ///< Inter-packet intervals, in seconds.
+        LogHistogram sizeHistogram;      ///< Histogram of packet sizes.
+        LogHistogram intervalHistogram;  ///< Histogram of inter-packet intervals.
+        std::vector<uint64_t> throughput; ///< Bytes per ThroughputInterval.
+        std::map<Address, Time> lastPacketByPeer; ///< Time of the last packet of each peer.
+    };
+
+    /**
+     * Returns the object TypeId.
+     * \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    IotStatsCollector();
+
+    /**
+     * Collect the Tx trace of every IotPassiveApp and the Rx trace of every
+     * IotClient of the container.
+     * \param apps The applications to collect.
+     */
+    void Attach(ApplicationContainer apps);
+
+    /**
+     * Statistics of a node, direction and sub-flow.
+     * \param nodeId The node.
+     * \param tx true for packets sent by an IotPassiveApp, false for packets
+     *           received by an IotClient.
+     * \param subFlowId The sub-flow, 0 for received packets.
+     * \return The statistics, or nullptr if no packet has been seen.
+     */
+    const FlowStats* GetFlowStats(uint32_t nodeId, bool tx, uint16_t subFlowId) const;
+
+    /**
+     * Call a function on the statistics of every flow, ordered by node.
+     * \param function Called with the node, the direction (true for Tx),
+     *                 the sub-flow and the statistics of each flow.
+     */
+    void ForEachFlow(
+        const std::function<void(uint32_t, bool, uint16_t, const FlowStats&)>& function) const;
+
+    /**
+     * Write a JSON summary of every flow, typically after Simulator::Run.
+     * \param filename Path of the file to write.
+     */
+    void WriteSummary(const std::string& filename) const;
+
+    /**
+     * Account a payload sent by an IotPassiveApp. Sink of its Tx trace,
+     * connected by Attach.
+     * \param nodeId Node of the application.
+     * \param packet The packet.
+     * \param address Address of the client.
+     * \param subFlowId SubFlow of the packet.
+     */
+    void CollectTx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address, uint16_t subFlowId);
+
+    /**
+     * Account a packet received by an IotClient. Sink of its Rx trace,
+     * connected by Attach.
+     * \param nodeId Node of the application.
+     * \param packet The packet.
+     * \param address Address of the sender.
+     */
+    void CollectRx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address);
+
+private:
+    /**
+     * Packed node, direction and sub-flow, ordering flows by node.
+     * \param nodeId The node.
+     * \param tx The direction.
+     * \param subFlowId The sub-flow.
+     * \return The key of the flow.
+     */
+    static uint64_t MakeKey(uint32_t nodeId, bool tx, uint16_t subFlowId);
+
+    /**
+     * Account a packet in the statistics of a flow.
+     * \param key Key of the flow.
+     * \param peer Address of the peer.
+     * \param size Size of the packet.
+     */
+    void Collect(uint64_t key, const Address& peer, uint32_t size);
+
+    Time m_throughputInterval;              ///< Width of the throughput bins.
+    std::map<uint64_t, FlowStats> m_flows;  ///< Statistics by flow key.
+};
+
+} // namespace ns3
+
+#endif /* IOT_STATS_COLLECTOR_H */
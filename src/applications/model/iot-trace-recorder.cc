@@ -0,0 +1,278 @@
+#include "iot-trace-recorder.h"
+
+#include "iot-client.h"
+#include "iot-passive-app.h"
+
+#include <ns3/abort.h>
+#include <ns3/inet-socket-address.h>
+#include <ns3/inet6-socket-address.h>
+#include <ns3/log.h>
+#include <ns3/node.h>
+#include <ns3/packet.h>
+#include <ns3/simulator.h>
+#include <ns3/uinteger.h>
+#include <cstring>
+#include <iomanip>
+
+NS_LOG_COMPONENT_DEFINE("IotTraceRecorder");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(IotTraceRecorder);
+
+namespace
+{
+
+/// Magic string at the start of a recorded file.
+const char RECORDER_MAGIC[8] = {'I', 'O', 'T', 'T', 'R', 'C', '0', '1'};
+
+/**
+ * Fill the peer fields of a record from a socket address.
+ * \param record The record.
+ * \param address The socket address of the peer.
+ */
+void
+SetPeer(IotTraceRecorder::Record& record, const Address& address)
+{
+    if (InetSocketAddress::IsMatchingType(address))
+    {
+        InetSocketAddress inetSocketAddress = InetSocketAddress::ConvertFrom(address);
+        inetSocketAddress.GetIpv4().Serialize(record.peer);
+        record.port = inetSocketAddress.GetPort();
+        record.family = 4;
+    }
+    else if (Inet6SocketAddress::IsMatchingType(address))
+    {
+        Inet6SocketAddress inetSocket6Address = Inet6SocketAddress::ConvertFrom(address);
+        inetSocket6Address.GetIpv6().Serialize(record.peer);
+        record.port = inetSocket6Address.GetPort();
+        record.family = 6;
+    }
+}
+
+} // namespace
+
+TypeId
+IotTraceRecorder::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::IotTraceRecorder")
+                            .SetParent<Object>()
+                            .AddConstructor<IotTraceRecorder>()
+                            .AddAttribute("RecordsPerBlock",
+                                          "Number of records buffered in memory before a block is "
+                                          "handed to the writer thread.",
+                                          UintegerValue(65536),
+                                          MakeUintegerAccessor(&IotTraceRecorder::m_recordsPerBlock),
+                                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+IotTraceRecorder::IotTraceRecorder()
+    : m_recordsPerBlock(65536)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+IotTraceRecorder::~IotTraceRecorder()
+{
+    Close();
+}
+
+void
+IotTraceRecorder::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+    Object::DoDispose();
+}
+
+void
+IotTraceRecorder::Open(const std::string& filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+    NS_ABORT_MSG_IF(m_file.is_open(), "IotTraceRecorder is already open.");
+
+    m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_IF(!m_file.is_open(), "Unable to open the file " << filename);
+    m_filename = filename;
+
+    uint32_t recordSize = sizeof(Record);
+    m_file.write(RECORDER_MAGIC, sizeof(RECORDER_MAGIC));
+    m_file.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+    NS_ABORT_MSG_IF(!m_file, "Unable to write the file " << m_filename);
+
+    m_block.reserve(m_recordsPerBlock);
+    m_stop = false;
+    m_writer = std::thread(&IotTraceRecorder::WriterLoop, this);
+}
+
+void
+IotTraceRecorder::Attach(ApplicationContainer apps)
+{
+    NS_LOG_FUNCTION(this);
+
+    for (auto it = apps.Begin(); it != apps.End(); ++it)
+    {
+        uint32_t nodeId = (*it)->GetNode()->GetId();
+        if (DynamicCast<IotPassiveApp>(*it))
+        {
+            (*it)->TraceConnectWithoutContext("Tx",
+                                              MakeCallback(&IotTraceRecorder::RecordTx, this).Bind(nodeId));
+        }
+        else if (DynamicCast<IotClient>(*it))
+        {
+            (*it)->TraceConnectWithoutContext("Rx",
+                                              MakeCallback(&IotTraceRecorder::RecordRx, this).Bind(nodeId));
+        }
+    }
+}
+
+void
+IotTraceRecorder::Close()
+{
+    if (!m_writer.joinable())
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_block.empty())
+        {
+            m_fullBlocks.push_back(std::move(m_block));
+        }
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_writer.join();
+
+    // Closing flushes the last bytes, which may fail too
+    m_file.close();
+    NS_ABORT_MSG_IF(!m_file, "Unable to write the file " << m_filename);
+    m_block = std::vector<Record>();
+    m_freeBlocks.clear();
+}
+
+void
+IotTraceRecorder::RecordTx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address, uint16_t subFlowId)
+{
+    Record record{};
+    record.time = Simulator::Now().GetNanoSeconds();
+    record.nodeId = nodeId;
+    record.size = packet->GetSize();
+    record.subFlowId = subFlowId;
+    record.direction = TX;
+    SetPeer(record, address);
+    Append(record);
+}
+
+void
+IotTraceRecorder::RecordRx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address)
+{
+    Record record{};
+    record.time = Simulator::Now().GetNanoSeconds();
+    record.nodeId = nodeId;
+    record.size = packet->GetSize();
+    record.direction = RX;
+    SetPeer(record, address);
+    Append(record);
+}
+
+void
+IotTraceRecorder::Append(const Record& record)
+{
+    if (!m_writer.joinable())
+    {
+        return;
+    }
+
+    m_block.push_back(record);
+    if (m_block.size() < m_recordsPerBlock)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fullBlocks.push_back(std::move(m_block));
+        if (m_freeBlocks.empty())
+        {
+            m_block = std::vector<Record>();
+        }
+        else
+        {
+            m_block = std::move(m_freeBlocks.back());
+            m_freeBlocks.pop_back();
+        }
+    }
+    m_cv.notify_one();
+    m_block.reserve(m_recordsPerBlock);
+}
+
+void
+IotTraceRecorder::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cv.wait(lock, [this] { return m_stop || !m_fullBlocks.empty(); });
+        if (m_fullBlocks.empty())
+        {
+            // Stopped and nothing left to write
+            return;
+        }
+
+        std::vector<Record> block = std::move(m_fullBlocks.front());
+        m_fullBlocks.pop_front();
+
+        // The file is only used by this thread, write without the lock
+        lock.unlock();
+        m_file.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(Record));
+        NS_ABORT_MSG_IF(!m_file, "Unable to write the file " << m_filename);
+        block.clear();
+        lock.lock();
+
+        m_freeBlocks.push_back(std::move(block));
+    }
+}
+
+void
+IotTraceRecorder::ConvertToCsv(const std::string& binaryFile, const std::string& csvFile)
+{
+    std::ifstream in(binaryFile, std::ios::in | std::ios::binary);
+    NS_ABORT_MSG_IF(!in.is_open(), "Unable to open the file " << binaryFile);
+
+    char magic[sizeof(RECORDER_MAGIC)];
+    uint32_t recordSize = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+    NS_ABORT_MSG_IF(!in || std::memcmp(magic, RECORDER_MAGIC, sizeof(magic)) != 0 ||
+                        recordSize != sizeof(Record),
+                    binaryFile << " is not a file written by IotTraceRecorder.");
+
+    std::ofstream out(csvFile, std::ios::out | std::ios::trunc);
+    NS_ABORT_MSG_IF(!out.is_open(), "Unable to open the file " << csvFile);
+    out << "Timestamp,Direction,NodeId,PeerAddress,PeerPort,SubFlowId,PacketSize\n";
+    out << std::fixed << std::setprecision(9);
+
+    Record record;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        out << record.time * 1e-9 << "," << (record.direction == TX ? "Tx" : "Rx") << ","
+            << record.nodeId << ",";
+        if (record.family == 4)
+        {
+            out << Ipv4Address::Deserialize(record.peer);
+        }
+        else if (record.family == 6)
+        {
+            out << Ipv6Address::Deserialize(record.peer);
+        }
+        out << "," << record.port << "," << record.subFlowId << "," << record.size << "\n";
+    }
+    NS_ABORT_MSG_IF(in.gcount() != 0, binaryFile << " ends with a truncated record.");
+    NS_ABORT_MSG_IF(!out, "Unable to write the file " << csvFile);
+}
+
+} // namespace ns3
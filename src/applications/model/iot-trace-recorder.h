@@ -0,0 +1,141 @@
+#ifndef IOT_TRACE_RECORDER_H
+#define IOT_TRACE_RECORDER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ns3/address.h>
+#include <ns3/application-container.h>
+#include <ns3/object.h>
+#include <ns3/ptr.h>
+
+namespace ns3
+{
+
+class Packet;
+
+/**
+ * \ingroup applications
+ * Binary recorder of the packets sent by IotPassiveApp and received by
+ * IotClient applications.
+ *
+ * Each Tx/Rx trace event is appended as a fixed-width Record to an
+ * in-memory block. Full blocks are handed to a background thread which
+ * writes them to the file, so the simulation never waits on formatting or
+ * disk I/O. ConvertToCsv turns a recorded file into CSV afterwards.
+ *
+ * The file starts with the 8-byte magic "IOTTRC01" and the record size as
+ * a uint32_t, followed by the records, in host byte order.
+ */
+class IotTraceRecorder : public Object
+{
+public:
+    /// Direction of a recorded packet.
+    enum Direction : uint8_t
+    {
+        TX = 0, ///< Sent by an IotPassiveApp.
+        RX = 1  ///< Received by an IotClient.
+    };
+
+    /// One recorded packet, as laid out in the file.
+    struct Record
+    {
+        int64_t time;      ///< Simulation time, in nanoseconds.
+        uint32_t nodeId;   ///< Node of the recording application.
+        uint32_t size;     ///< Packet size, in bytes.
+        uint8_t peer[16];  ///< IPv4 (first 4 bytes) or IPv6 address of the peer.
+        uint16_t port;     ///< Port of the peer.
+        uint16_t subFlowId; ///< SubFlow of the packet, 0 for received packets.
+        uint8_t direction; ///< Direction of the packet.
+        uint8_t family;    ///< 4 or 6 for an IPv4 or IPv6 peer, 0 if unknown.
+        uint8_t reserved[2]; ///< Padding, always 0.
+    };
+
+    /**
+     * Returns the object TypeId.
+     * \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    IotTraceRecorder();
+
+    ~IotTraceRecorder() override;
+
+    /**
+     * Open the output file and start the writer thread. A failed write,
+     * such as on a full disk, is a fatal error rather than a truncated file.
+     * \param filename Path of the binary file to write.
+     */
+    void Open(const std::string& filename);
+
+    /**
+     * Record the Tx trace of every IotPassiveApp and the Rx trace of every
+     * IotClient of the container.
+     * \param apps The applications to record.
+     */
+    void Attach(ApplicationContainer apps);
+
+    /**
+     * Write the pending records, stop the writer thread and close the file.
+     * Called on dispose if needed.
+     */
+    void Close();
+
+    /**
+     * Convert a binary file written by this class into CSV.
+     * \param binaryFile Path of the binary file to read.
+     * \param csvFile Path of the CSV file to write.
+     */
+    static void ConvertToCsv(const std::string& binaryFile, const std::string& csvFile);
+
+protected:
+    void DoDispose() override;
+
+private:
+    /**
+     * Record a packet sent by an IotPassiveApp.
+     * \param nodeId Node of the application.
+     * \param packet The packet.
+     * \param address Address of the client.
+     * \param subFlowId SubFlow of the packet.
+     */
+    void RecordTx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address, uint16_t subFlowId);
+
+    /**
+     * Record a packet received by an IotClient.
+     * \param nodeId Node of the application.
+     * \param packet The packet.
+     * \param address Address of the sender.
+     */
+    void RecordRx(uint32_t nodeId, Ptr<const Packet> packet, const Address& address);
+
+    /**
+     * Append a record to the current block, handing the block to the
+     * writer thread when full.
+     * \param record The record.
+     */
+    void Append(const Record& record);
+
+    /// Main loop of the writer thread.
+    void WriterLoop();
+
+    uint32_t m_recordsPerBlock;     ///< Number of records per block.
+    std::ofstream m_file;           ///< Output file, only used by the writer thread once open.
+    std::string m_filename;         ///< Path of the output file, for errors.
+    std::vector<Record> m_block;    ///< Block being filled by the simulation.
+    std::deque<std::vector<Record>> m_fullBlocks; ///< Blocks waiting to be written.
+    std::vector<std::vector<Record>> m_freeBlocks; ///< Written blocks, reused.
+    std::mutex m_mutex;             ///< Protects m_fullBlocks, m_freeBlocks and m_stop.
+    std::condition_variable m_cv;   ///< Wakes up the writer thread.
+    std::thread m_writer;           ///< Writer thread.
+    bool m_stop{false};             ///< Asks the writer thread to exit.
+};
+
+} // namespace ns3
+
+#endif /* IOT_TRACE_RECORDER_H */
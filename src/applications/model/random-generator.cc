@@ -1,59 +1,1004 @@
 #include "random-generator.h"
 
+#include <ns3/abort.h>
+#include <ns3/rng-seed-manager.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace ns3 
 {
 
+namespace
+{
+
+/**
+ * Seed a standard engine from the global seed, the run number and a stream
+ * index, so that it follows RngSeedManager like ns-3 random variables do.
+ */
+template <class Engine>
+void
+SeedFromStream(Engine& engine, uint64_t stream)
+{
+    uint64_t run = RngSeedManager::GetRun();
+    std::seed_seq seq{RngSeedManager::GetSeed(),
+                      static_cast<uint32_t>(run),
+                      static_cast<uint32_t>(run >> 32),
+                      static_cast<uint32_t>(stream),
+                      static_cast<uint32_t>(stream >> 32)};
+    engine.seed(seq);
+}
+
+/// Scale mapping a 32-bit engine output to [0, 1).
+constexpr double UINT32_TO_UNIT = 1.0 / 4294967296.0;
+
+/**
+ * Draw a uniform sample in (0, 1), whose logarithm is finite.
+ * \param engine The engine to draw from.
+ * \return The sample.
+ */
+inline double
+OpenUnit(RandomEngine& engine)
+{
+    return (engine() + 0.5) * UINT32_TO_UNIT;
+}
+
+/**
+ * Build a Walker/Vose alias table, drawing bin i with probability
+ * weights[i] / sum(weights).
+ * \param weights Non-negative weights, of positive sum.
+ * \param thresholds Set to the probability of keeping each bin.
+ * \param aliases Set to the bin drawn when a bin is not kept.
+ */
+void
+BuildAliasTable(const std::vector<double>& weights,
+                std::vector<double>& thresholds,
+                std::vector<uint32_t>& aliases)
+{
+    std::size_t n = weights.size();
+    double total = 0;
+    for (double weight : weights) {
+        total += weight;
+    }
+    NS_ABORT_MSG_IF(n == 0 || !(total > 0), "Alias table weights must sum to a positive value.");
+
+    // Vose's alias method: scale weights so that the mean bin weight is 1,
+    // then pair every light bin with a heavy one
+    std::vector<double> scaled(n);
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+    for (std::size_t i = 0; i < n; ++i) {
+        scaled[i] = weights[i] * n / total;
+        if (scaled[i] < 1.0) {
+            small.push_back(i);
+        } else {
+            large.push_back(i);
+        }
+    }
+
+    thresholds.assign(n, 1.0);
+    aliases.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        aliases[i] = i;
+    }
+    while (!small.empty() && !large.empty()) {
+        std::size_t light = small.back();
+        small.pop_back();
+        std::size_t heavy = large.back();
+
+        thresholds[light] = scaled[light];
+        aliases[light] = heavy;
+        scaled[heavy] = (scaled[heavy] + scaled[light]) - 1.0;
+        if (scaled[heavy] < 1.0) {
+            large.pop_back();
+            small.push_back(heavy);
+        }
+    }
+    // Whatever remains only differs from 1 by rounding errors and keeps its
+    // threshold of 1
+}
+
+/**
+ * Layers of the Ziggurat of the standard normal law (Marsaglia and Tsang,
+ * 2000), computed once.
+ *
+ * Layer 0 is the base strip, made of a rectangle and of the tail beyond R;
+ * every layer has the same area V. Layer i spans [0, x[i]] horizontally and
+ * [f[i], f[i + 1]] vertically, f being the unnormalized density.
+ */
+struct NormalZiggurat
+{
+    static constexpr std::size_t LAYERS = 128;        ///< Number of layers, a power of two.
+    static constexpr double R = 3.442619855899;       ///< Start of the tail.
+    static constexpr double V = 9.91256303526217e-3;  ///< Area of each layer.
+
+    double x[LAYERS + 1]; ///< Right edge of each layer.
+    double f[LAYERS + 1]; ///< Density at the right edge of each layer.
+
+    NormalZiggurat()
+    {
+        f[1] = std::exp(-0.5 * R * R);
+        x[0] = V / f[1];
+        f[0] = 0;
+        x[1] = R;
+        for (std::size_t i = 2; i < LAYERS; ++i) {
+            x[i] = std::sqrt(-2 * std::log(V / x[i - 1] + f[i - 1]));
+            f[i] = std::exp(-0.5 * x[i] * x[i]);
+        }
+        x[LAYERS] = 0;
+        f[LAYERS] = 1;
+    }
+
+    /// \return The Ziggurat.
+    static const NormalZiggurat& Get()
+    {
+        static const NormalZiggurat ziggurat;
+        return ziggurat;
+    }
+};
+
+/**
+ * Decode 64 random bits into a Ziggurat candidate: a layer, a sign and a
+ * position uniform over the width of the layer. The layer and the sign take
+ * the low 8 bits, the position the high 53 bits.
+ *
+ * \param ziggurat The Ziggurat.
+ * \param bits The random bits.
+ * \param layer Set to the layer of the candidate.
+ * \return The signed candidate.
+ */
+inline double
+DecodeZiggurat(const NormalZiggurat& ziggurat, uint64_t bits, std::size_t& layer)
+{
+    layer = bits & (NormalZiggurat::LAYERS - 1);
+    double x = (bits >> 11) * 0x1.0p-53 * ziggurat.x[layer];
+    return (bits & NormalZiggurat::LAYERS) ? -x : x;
+}
+
+/**
+ * Finish a Ziggurat draw whose candidate lies beyond the rectangle of its
+ * layer: sample the tail for the base strip, or test the candidate against
+ * the density for the others.
+ *
+ * \param engine The engine to draw from.
+ * \param layer The layer of the candidate.
+ * \param candidate The signed candidate.
+ * \param sample Set to the sample when the draw is accepted.
+ * \return Whether the draw is accepted.
+ */
+bool
+FinishZiggurat(RandomEngine& engine, std::size_t layer, double candidate, double& sample)
+{
+    const NormalZiggurat& ziggurat = NormalZiggurat::Get();
+    if (layer == 0) {
+        // Tail beyond R, by Marsaglia's method
+        double a;
+        double b;
+        do {
+            a = -std::log(OpenUnit(engine)) / NormalZiggurat::R;
+            b = -std::log(OpenUnit(engine));
+        } while (2 * b < a * a);
+        sample = std::copysign(NormalZiggurat::R + a, candidate);
+        return true;
+    }
+    double y = ziggurat.f[layer] +
+               engine() * UINT32_TO_UNIT * (ziggurat.f[layer + 1] - ziggurat.f[layer]);
+    sample = candidate;
+    return y < std::exp(-0.5 * candidate * candidate);
+}
+
+/**
+ * Draw a sample of the standard normal law with the Ziggurat method.
+ *
+ * Two engine outputs give the layer, the sign and 53 bits of position; about
+ * 99% of the samples are accepted right away, without any transcendental
+ * function.
+ *
+ * \param engine The engine to draw from.
+ * \return The sample.
+ */
+double
+SampleZiggurat(RandomEngine& engine)
+{
+    const NormalZiggurat& ziggurat = NormalZiggurat::Get();
+    while (true) {
+        uint64_t bits = static_cast<uint64_t>(engine()) << 32 | engine();
+        std::size_t layer;
+        double candidate = DecodeZiggurat(ziggurat, bits, layer);
+        double sample;
+        if (std::abs(candidate) < ziggurat.x[layer + 1]) {
+            // Inside the part of the layer below the density
+            return candidate;
+        }
+        if (FinishZiggurat(engine, layer, candidate, sample)) {
+            return sample;
+        }
+    }
+}
+
+/// Magic string at the start of a replay sample file.
+const char REPLAY_MAGIC[8] = {'I', 'O', 'T', 'R', 'P', 'L', '0', '1'};
+
+/// Size of the replay file header: magic and number of samples.
+constexpr std::size_t REPLAY_HEADER_SIZE = sizeof(REPLAY_MAGIC) + sizeof(uint64_t);
+
+} // namespace
+
+void
+RandomGeneratorState::Seed(uint64_t stream)
+{
+    SeedFromStream(engine, stream);
+    position = UNSET;
+    start = UNSET;
+}
+
+double
+RandomGenerator::GetRandom(RandomGeneratorState& /* state */) const
+{
+    return GetRandom();
+}
+
+void
+RandomGenerator::Fill(double* out, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = GetRandom();
+    }
+}
+
+void
+RandomGenerator::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = GetRandom(state);
+    }
+}
+
+int64_t
+RandomGenerator::AssignStreams(int64_t /* stream */)
+{
+    return 0;
+}
+
 RandomGeneratorUniform::RandomGeneratorUniform(double min, double max)
     : m_min(min), m_max(max)
 {
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
 }
 
 double
 RandomGeneratorUniform::GetRandom() const
 {
-    double random = m_min + (rand() / (double)RAND_MAX) * (m_max - m_min);
-    return random;
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorUniform::GetRandom(RandomGeneratorState& state) const
+{
+    return m_min + state.engine() * ((m_max - m_min) * UINT32_TO_UNIT);
+}
+
+void
+RandomGeneratorUniform::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorUniform::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    // Draw the raw engine output first, then scale it in a separate loop
+    // free of dependencies, which the compiler vectorizes
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = state.engine();
+    }
+    const double scale = (m_max - m_min) * UINT32_TO_UNIT;
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = m_min + out[i] * scale;
+    }
+}
+
+int64_t
+RandomGeneratorUniform::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
 }
 
 RandomGeneratorDist::RandomGeneratorDist(
     const std::vector<std::pair<double, double>>& distribution)
-    : m_distribution(distribution)
 {
-    // Initialize packet size distribution
-    std::vector<double> probabilities;
+    NS_ABORT_MSG_IF(distribution.empty(), "RandomGeneratorDist needs at least one value.");
+
+    std::size_t n = distribution.size();
+    std::vector<double> weights;
     for (const auto& pair : distribution) {
-        probabilities.push_back(pair.second);
+        weights.push_back(pair.second);
     }
-    m_discreteDistributionObj = std::discrete_distribution<>(
-        probabilities.begin(), probabilities.end());
+    std::vector<uint32_t> alias;
+    BuildAliasTable(weights, m_thresholds, alias);
 
+    m_values.resize(n);
+    m_aliasValues.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        m_values[i] = distribution[i].first;
+        m_aliasValues[i] = distribution[alias[i]].first;
+    }
+
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
 }
 
 double
 RandomGeneratorDist::GetRandom() const
 {
-    int index = m_discreteDistributionObj(m_rng);
-    return m_distribution[index].first;
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorDist::GetRandom(RandomGeneratorState& state) const
+{
+    double u = state.engine() * (m_thresholds.size() * UINT32_TO_UNIT);
+    std::size_t bin = static_cast<std::size_t>(u);
+    return (u - bin) < m_thresholds[bin] ? m_values[bin] : m_aliasValues[bin];
+}
+
+void
+RandomGeneratorDist::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorDist::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    const std::size_t bins = m_thresholds.size();
+    const double scale = bins * UINT32_TO_UNIT;
+    const double* thresholds = m_thresholds.data();
+    const double* values = m_values.data();
+    const double* aliasValues = m_aliasValues.data();
+
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = state.engine();
+    }
+    // Branch-free alias lookup, vectorized as gathers and a blend
+    for (std::size_t i = 0; i < n; ++i) {
+        double u = out[i] * scale;
+        std::size_t bin = static_cast<std::size_t>(u);
+        out[i] = (u - bin) < thresholds[bin] ? values[bin] : aliasValues[bin];
+    }
+}
+
+int64_t
+RandomGeneratorDist::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
 }
 
 RandomGeneratorNormal::RandomGeneratorNormal(double min, double max, double mean, double stdDev)
-    : m_min(min), m_max(max), m_mean(mean), m_stdDev(stdDev)
+    : m_min(min), m_max(max), m_mean(mean), m_stdDev(stdDev),
+      m_method(Method::CONSTANT),
+      m_mirrored(false),
+      m_alpha(0),
+      m_beta(0),
+      m_lambda(0),
+      m_closest(0)
+{
+    NS_ABORT_MSG_IF(max < min, "RandomGeneratorNormal needs min <= max.");
+
+    if (stdDev > 0 && min < max) {
+        m_alpha = (min - mean) / stdDev;
+        m_beta = (max - mean) / stdDev;
+        if (m_beta < 0) {
+            // The law is symmetric: sample the mirrored window above the mean
+            m_mirrored = true;
+            std::swap(m_alpha, m_beta);
+            m_alpha = -m_alpha;
+            m_beta = -m_beta;
+        }
+        m_closest = std::max(m_alpha, 0.0);
+
+        // Logarithms of the acceptance rates of the samplers, divided by
+        // the integral of the density over the window
+        double zigguratRate = -0.5 * std::log(2 * M_PI);
+        double uniformRate = 0.5 * m_closest * m_closest - std::log(m_beta - m_alpha);
+        double exponentialRate = -std::numeric_limits<double>::infinity();
+        if (m_alpha > 0) {
+            // Robert's optimal rate for proposals beyond alpha
+            m_lambda = 0.5 * (m_alpha + std::sqrt(m_alpha * m_alpha + 4));
+            exponentialRate = std::log(m_lambda) + m_lambda * m_alpha - 0.5 * m_lambda * m_lambda;
+        }
+
+        m_method = Method::ZIGGURAT;
+        if (uniformRate > zigguratRate && uniformRate >= exponentialRate) {
+            m_method = Method::UNIFORM;
+        } else if (exponentialRate > zigguratRate) {
+            m_method = Method::EXPONENTIAL;
+        }
+    }
+
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+double
+RandomGeneratorNormal::SampleStandard(RandomGeneratorState& state) const
 {
+    switch (m_method) {
+    case Method::ZIGGURAT:
+        while (true) {
+            double z = SampleZiggurat(state.engine);
+            if (z >= m_alpha && z <= m_beta) {
+                return z;
+            }
+        }
+    case Method::UNIFORM:
+        while (true) {
+            double z = m_alpha + (m_beta - m_alpha) * (state.engine() * UINT32_TO_UNIT);
+            if (OpenUnit(state.engine) <= std::exp(0.5 * (m_closest * m_closest - z * z))) {
+                return z;
+            }
+        }
+    case Method::EXPONENTIAL:
+        while (true) {
+            double z = m_alpha - std::log(OpenUnit(state.engine)) / m_lambda;
+            if (z <= m_beta &&
+                OpenUnit(state.engine) <= std::exp(-0.5 * (z - m_lambda) * (z - m_lambda))) {
+                return z;
+            }
+        }
+    case Method::CONSTANT:
+        break;
+    }
+    return 0;
 }
 
 double
 RandomGeneratorNormal::GetRandom() const
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::normal_distribution<> d(m_mean, m_stdDev);
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorNormal::GetRandom(RandomGeneratorState& state) const
+{
+    double z = SampleStandard(state);
+    double randomValue = m_mean + m_stdDev * (m_mirrored ? -z : z);
+
+    // Only rounding errors can cross the bounds
+    return std::min(std::max(randomValue, m_min), m_max);
+}
+
+void
+RandomGeneratorNormal::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorNormal::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    if (m_method != Method::ZIGGURAT) {
+        // The uniform and exponential proposals accept too rarely to gain
+        // from blocks; the class being final, these calls are not virtual
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = GetRandom(state);
+        }
+        return;
+    }
 
-    double randomValue = d(gen);
+    const NormalZiggurat& ziggurat = NormalZiggurat::Get();
+    constexpr std::size_t BLOCK_SIZE = 64;
+    uint64_t bits[BLOCK_SIZE];
+    double candidates[BLOCK_SIZE];
+    uint8_t accepted[BLOCK_SIZE];
+    while (n > 0) {
+        std::size_t count = std::min(n, BLOCK_SIZE);
 
-    if (randomValue < m_min) return m_min;
-    if (randomValue > m_max) return m_max;
+        // The engine is sequential: draw the bits of the whole block first
+        for (std::size_t i = 0; i < count; ++i) {
+            bits[i] = static_cast<uint64_t>(state.engine()) << 32 | state.engine();
+        }
+
+        // Layers, positions and the rectangle and window tests, without
+        // branches so that the loop vectorizes
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t layer;
+            double candidate = DecodeZiggurat(ziggurat, bits[i], layer);
+            candidates[i] = candidate;
+            accepted[i] = (std::abs(candidate) < ziggurat.x[layer + 1]) &
+                          (candidate >= m_alpha) & (candidate <= m_beta);
+        }
+
+        // Scalar fallback for the candidates in a wedge or in the tail, or
+        // out of the window, then back to the bounds of the law
+        for (std::size_t i = 0; i < count; ++i) {
+            double z = candidates[i];
+            if (!accepted[i]) {
+                std::size_t layer = bits[i] & (NormalZiggurat::LAYERS - 1);
+                double sample = 0;
+                bool finished = std::abs(z) >= ziggurat.x[layer + 1] &&
+                                FinishZiggurat(state.engine, layer, z, sample);
+                z = finished && sample >= m_alpha && sample <= m_beta ? sample
+                                                                      : SampleStandard(state);
+            }
+            double randomValue = m_mean + m_stdDev * (m_mirrored ? -z : z);
+            out[i] = std::min(std::max(randomValue, m_min), m_max);
+        }
+
+        out += count;
+        n -= count;
+    }
+}
+
+int64_t
+RandomGeneratorNormal::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+RandomGeneratorExponential::RandomGeneratorExponential(double mean, double min, double max)
+    : m_mean(mean), m_min(min), m_max(max)
+{
+    NS_ABORT_MSG_IF(!(mean > 0), "RandomGeneratorExponential needs a positive mean.");
+    NS_ABORT_MSG_IF(min < 0 || !(min < max), "RandomGeneratorExponential needs 0 <= min < max.");
+
+    m_survivalMin = std::exp(-min / mean);
+    m_survivalSpan = m_survivalMin - std::exp(-max / mean);
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+double
+RandomGeneratorExponential::GetRandom() const
+{
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorExponential::GetRandom(RandomGeneratorState& state) const
+{
+    // Survival in (S(max), S(min)], whose logarithm is finite
+    double survival = m_survivalMin - state.engine() * UINT32_TO_UNIT * m_survivalSpan;
+    double randomValue = -m_mean * std::log(survival);
+    return std::min(std::max(randomValue, m_min), m_max);
+}
+
+void
+RandomGeneratorExponential::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorExponential::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = GetRandom(state);
+    }
+}
+
+int64_t
+RandomGeneratorExponential::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+RandomGeneratorPareto::RandomGeneratorPareto(double scale, double shape, double min, double max)
+    : m_scale(scale), m_min(min == 0 ? scale : min), m_max(max)
+{
+    NS_ABORT_MSG_IF(!(scale > 0) || !(shape > 0),
+                    "RandomGeneratorPareto needs a positive scale and shape.");
+    NS_ABORT_MSG_IF(m_min < scale || !(m_min < max),
+                    "RandomGeneratorPareto needs scale <= min < max.");
+
+    m_exponent = -1 / shape;
+    m_survivalMin = std::pow(scale / m_min, shape);
+    m_survivalSpan = m_survivalMin - std::pow(scale / max, shape);
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+double
+RandomGeneratorPareto::GetRandom() const
+{
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorPareto::GetRandom(RandomGeneratorState& state) const
+{
+    double survival = m_survivalMin - state.engine() * UINT32_TO_UNIT * m_survivalSpan;
+    double randomValue = m_scale * std::pow(survival, m_exponent);
+    return std::min(std::max(randomValue, m_min), m_max);
+}
+
+void
+RandomGeneratorPareto::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorPareto::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = GetRandom(state);
+    }
+}
+
+int64_t
+RandomGeneratorPareto::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+RandomGeneratorWeibull::RandomGeneratorWeibull(double scale, double shape, double min, double max)
+    : m_scale(scale), m_min(min), m_max(max)
+{
+    NS_ABORT_MSG_IF(!(scale > 0) || !(shape > 0),
+                    "RandomGeneratorWeibull needs a positive scale and shape.");
+    NS_ABORT_MSG_IF(min < 0 || !(min < max), "RandomGeneratorWeibull needs 0 <= min < max.");
+
+    m_exponent = 1 / shape;
+    m_survivalMin = std::exp(-std::pow(min / scale, shape));
+    m_survivalSpan = m_survivalMin - std::exp(-std::pow(max / scale, shape));
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+double
+RandomGeneratorWeibull::GetRandom() const
+{
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorWeibull::GetRandom(RandomGeneratorState& state) const
+{
+    double survival = m_survivalMin - state.engine() * UINT32_TO_UNIT * m_survivalSpan;
+    double randomValue = m_scale * std::pow(-std::log(survival), m_exponent);
+    return std::min(std::max(randomValue, m_min), m_max);
+}
+
+void
+RandomGeneratorWeibull::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorWeibull::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = GetRandom(state);
+    }
+}
+
+int64_t
+RandomGeneratorWeibull::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+RandomGeneratorLognormal::RandomGeneratorLognormal(double mu, double sigma, double min, double max)
+    : m_min(min), m_max(max),
+      m_logarithm(std::log(min), std::log(max), mu, sigma)
+{
+    NS_ABORT_MSG_IF(!(sigma > 0), "RandomGeneratorLognormal needs a positive sigma.");
+    NS_ABORT_MSG_IF(min < 0 || !(min < max), "RandomGeneratorLognormal needs 0 <= min < max.");
+
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+double
+RandomGeneratorLognormal::GetRandom() const
+{
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorLognormal::GetRandom(RandomGeneratorState& state) const
+{
+    double randomValue = std::exp(m_logarithm.GetRandom(state));
+    return std::min(std::max(randomValue, m_min), m_max);
+}
+
+void
+RandomGeneratorLognormal::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorLognormal::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = GetRandom(state);
+    }
+}
+
+int64_t
+RandomGeneratorLognormal::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+RandomGeneratorEmpirical::RandomGeneratorEmpirical(
+    const std::vector<std::pair<double, double>>& cdf)
+{
+    NS_ABORT_MSG_IF(cdf.empty(), "RandomGeneratorEmpirical needs at least one point.");
+    NS_ABORT_MSG_IF(std::abs(cdf.back().second - 1) > 1e-9,
+                    "RandomGeneratorEmpirical cumulative probabilities must end at 1.");
+
+    // Segment 0 is the first value itself, segment i spans points i - 1 to i
+    std::vector<double> weights;
+    double previousValue = cdf.front().first;
+    double previousProbability = 0;
+    for (const auto& [value, probability] : cdf) {
+        NS_ABORT_MSG_IF(value < previousValue || probability < previousProbability,
+                        "RandomGeneratorEmpirical points must be non-decreasing.");
+        weights.push_back(probability - previousProbability);
+        m_starts.push_back(previousValue);
+        m_widths.push_back(value - previousValue);
+        previousValue = value;
+        previousProbability = probability;
+    }
+    BuildAliasTable(weights, m_thresholds, m_aliases);
+
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+double
+RandomGeneratorEmpirical::GetRandom() const
+{
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorEmpirical::GetRandom(RandomGeneratorState& state) const
+{
+    double u = state.engine() * (m_thresholds.size() * UINT32_TO_UNIT);
+    std::size_t bin = static_cast<std::size_t>(u);
+    std::size_t segment = (u - bin) < m_thresholds[bin] ? bin : m_aliases[bin];
+    return m_starts[segment] + m_widths[segment] * (state.engine() * UINT32_TO_UNIT);
+}
+
+void
+RandomGeneratorEmpirical::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorEmpirical::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = GetRandom(state);
+    }
+}
+
+int64_t
+RandomGeneratorEmpirical::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+RandomGeneratorJoint::RandomGeneratorJoint(const std::vector<double>& firstEdges,
+                                           const std::vector<double>& secondEdges,
+                                           const std::vector<double>& weights)
+{
+    NS_ABORT_MSG_IF(firstEdges.size() < 2 || secondEdges.size() < 2,
+                    "RandomGeneratorJoint needs at least one bin per component.");
+    NS_ABORT_MSG_IF(!std::is_sorted(firstEdges.begin(), firstEdges.end()) ||
+                        !std::is_sorted(secondEdges.begin(), secondEdges.end()),
+                    "RandomGeneratorJoint edges must be non-decreasing.");
+    std::size_t columns = secondEdges.size() - 1;
+    NS_ABORT_MSG_IF(weights.size() != (firstEdges.size() - 1) * columns,
+                    "RandomGeneratorJoint needs one weight per cell.");
+
+    BuildAliasTable(weights, m_thresholds, m_aliases);
+
+    // Cell bounds are stored flat, so that a draw needs no division
+    for (std::size_t cell = 0; cell < weights.size(); ++cell) {
+        std::size_t row = cell / columns;
+        std::size_t column = cell % columns;
+        m_firstStarts.push_back(firstEdges[row]);
+        m_firstWidths.push_back(firstEdges[row + 1] - firstEdges[row]);
+        m_secondStarts.push_back(secondEdges[column]);
+        m_secondWidths.push_back(secondEdges[column + 1] - secondEdges[column]);
+    }
+
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+std::pair<double, double>
+RandomGeneratorJoint::GetRandom() const
+{
+    return GetRandom(m_state);
+}
+
+std::pair<double, double>
+RandomGeneratorJoint::GetRandom(RandomGeneratorState& state) const
+{
+    double u = state.engine() * (m_thresholds.size() * UINT32_TO_UNIT);
+    std::size_t bin = static_cast<std::size_t>(u);
+    std::size_t cell = (u - bin) < m_thresholds[bin] ? bin : m_aliases[bin];
+
+    // One engine output per component, so that the positions within wide
+    // cells are fine-grained and independent
+    double first = state.engine() * UINT32_TO_UNIT;
+    double second = state.engine() * UINT32_TO_UNIT;
+    return {m_firstStarts[cell] + m_firstWidths[cell] * first,
+            m_secondStarts[cell] + m_secondWidths[cell] * second};
+}
+
+int64_t
+RandomGeneratorJoint::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+class RandomGeneratorReplay::MappedFile
+{
+public:
+    /**
+     * Map a sample file and check its header.
+     * \param filename Path of the sample file.
+     */
+    MappedFile(const std::string& filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        NS_ABORT_MSG_IF(fd < 0, "Unable to open the file " << filename);
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= REPLAY_HEADER_SIZE) {
+            m_length = st.st_size;
+            m_data = mmap(nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        // The mapping stays valid once the descriptor is closed
+        ::close(fd);
+        NS_ABORT_MSG_IF(m_data == nullptr || m_data == MAP_FAILED,
+                        "Unable to map the file " << filename);
+
+        const char* bytes = static_cast<const char*>(m_data);
+        uint64_t count;
+        std::memcpy(&count, bytes + sizeof(REPLAY_MAGIC), sizeof(count));
+        NS_ABORT_MSG_IF(std::memcmp(bytes, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 ||
+                            count == 0 ||
+                            (m_length - REPLAY_HEADER_SIZE) / sizeof(double) < count,
+                        filename << " is not a replay sample file.");
+
+        // The header keeps the samples 8-byte aligned within the page-aligned mapping
+        m_samples = reinterpret_cast<const double*>(bytes + REPLAY_HEADER_SIZE);
+        m_size = count;
+    }
+
+    ~MappedFile()
+    {
+        munmap(m_data, m_length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Return the mapping of a file, shared with the generators which
+     * already replay it.
+     * \param filename Path of the sample file.
+     * \return The mapping.
+     */
+    static std::shared_ptr<const MappedFile> Get(const std::string& filename)
+    {
+        static std::map<std::string, std::weak_ptr<const MappedFile>> mappings;
+
+        std::shared_ptr<const MappedFile> file = mappings[filename].lock();
+        if (!file) {
+            file = std::make_shared<const MappedFile>(filename);
+            mappings[filename] = file;
+        }
+        return file;
+    }
+
+    void* m_data{nullptr};        ///< Start of the mapping.
+    std::size_t m_length{0};      ///< Length of the mapping.
+    const double* m_samples{nullptr}; ///< First sample.
+    std::size_t m_size{0};        ///< Number of samples.
+};
+
+RandomGeneratorReplay::RandomGeneratorReplay(const std::string& filename)
+    : m_file(MappedFile::Get(filename)),
+      m_samples(m_file->m_samples),
+      m_size(m_file->m_size)
+{
+    m_state.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
+std::size_t
+RandomGeneratorReplay::GetPosition(RandomGeneratorState& state) const
+{
+    if (state.position >= m_size) {
+        // First read of the state: start at its own offset, or a random one
+        state.position = (state.start != RandomGeneratorState::UNSET)
+                             ? state.start % m_size
+                             : std::uniform_int_distribution<uint64_t>(0, m_size - 1)(state.engine);
+    }
+    return state.position;
+}
+
+double
+RandomGeneratorReplay::GetRandom() const
+{
+    return GetRandom(m_state);
+}
+
+double
+RandomGeneratorReplay::GetRandom(RandomGeneratorState& state) const
+{
+    std::size_t next = GetPosition(state);
+    double sample = m_samples[next];
+    state.position = (next + 1 == m_size) ? 0 : next + 1;
+    return sample;
+}
+
+void
+RandomGeneratorReplay::Fill(double* out, std::size_t n) const
+{
+    Fill(m_state, out, n);
+}
+
+void
+RandomGeneratorReplay::Fill(RandomGeneratorState& state, double* out, std::size_t n) const
+{
+    std::size_t next = GetPosition(state);
+    while (n > 0) {
+        std::size_t count = std::min(n, m_size - next);
+        std::memcpy(out, m_samples + next, count * sizeof(double));
+        out += count;
+        n -= count;
+        next += count;
+        if (next == m_size) {
+            next = 0;
+        }
+    }
+    state.position = next;
+}
+
+int64_t
+RandomGeneratorReplay::AssignStreams(int64_t stream)
+{
+    m_state.Seed(stream);
+    return 1;
+}
+
+std::size_t
+RandomGeneratorReplay::GetSize() const
+{
+    return m_size;
+}
+
+void
+RandomGeneratorReplay::WriteSampleFile(const std::string& filename, const std::vector<double>& samples)
+{
+    std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_IF(!out.is_open(), "Unable to open the file " << filename);
 
-    return randomValue;
+    uint64_t count = samples.size();
+    out.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(double));
+    NS_ABORT_MSG_IF(!out, "Unable to write the file " << filename);
 }
 
 } // namespace ns3
@@ -1,17 +1,106 @@
 #ifndef RANDOM_GENERATOR_H
 #define RANDOM_GENERATOR_H
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 #include <random>
 
 namespace ns3
 {
 
+/**
+ * \ingroup applications
+ * Small random engine (PCG32, XSH-RR output) used by the generators.
+ *
+ * Its 16 bytes of state let every application keep its own engines while
+ * sharing the generators of a traffic profile. It satisfies the standard
+ * UniformRandomBitGenerator requirements.
+ */
+class RandomEngine
+{
+public:
+    using result_type = uint32_t;
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    /**
+     * Seed the engine from a seed sequence.
+     * \param seq The seed sequence.
+     */
+    template <class SeedSeq>
+    void seed(SeedSeq& seq)
+    {
+        uint32_t words[4];
+        seq.generate(words, words + 4);
+        m_state = 0;
+        m_inc = ((static_cast<uint64_t>(words[2]) << 32 | words[3]) << 1) | 1;
+        (*this)();
+        m_state += static_cast<uint64_t>(words[0]) << 32 | words[1];
+        (*this)();
+    }
+
+    /// \return The next 32-bit output.
+    result_type operator()()
+    {
+        uint64_t old = m_state;
+        m_state = old * 6364136223846793005ULL + m_inc;
+        auto xorShifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        auto rotation = static_cast<uint32_t>(old >> 59);
+        return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+    }
+
+private:
+    uint64_t m_state{0x853c49e6748fea9bULL}; ///< Current state.
+    uint64_t m_inc{0xda3e39cb94b95bdbULL};   ///< Odd increment, selects the sequence.
+};
+
+/**
+ * \ingroup applications
+ * Mutable part of a generator: its engine and, for generators reading a
+ * sequence, the position in the sequence.
+ *
+ * Generators are immutable once built and draw from a state passed by the
+ * caller, so one generator can serve any number of independent states.
+ */
+struct RandomGeneratorState
+{
+    /// Position of a state which has not read its sequence yet.
+    static constexpr uint64_t UNSET = UINT64_MAX;
+
+    RandomEngine engine;     ///< Engine of the state.
+    uint64_t position{UNSET}; ///< Position in the sequence of the generator.
+
+    /**
+     * Start offset of a replayed sequence, modulo its size. When UNSET, the
+     * offset is drawn from the engine on the first read. States given the
+     * same start read the samples of the same indices.
+     */
+    uint64_t start{UNSET};
+
+    /**
+     * Seed the engine from the global seed, the run number and a stream,
+     * and rewind the sequence to a start offset to draw.
+     * \param stream Stream index used to derive the seed.
+     */
+    void Seed(uint64_t stream);
+};
+
 /**
  * \ingroup applications
  * Modelize a generation method.
+ *
+ * GetRandom() and Fill(out, n) draw from the generator's own state. The
+ * overloads taking a RandomGeneratorState draw from the caller's state
+ * instead, and are the ones to use when a generator is shared.
  */
-class RandomGenerator 
+class RandomGenerator
 {
 public:
 
@@ -19,13 +108,59 @@ public:
 
     virtual double GetRandom() const = 0;
 
+    /**
+     * Draw a sample from a caller-provided state.
+     *
+     * The default implementation ignores \p state and calls GetRandom.
+     *
+     * \param state The state to draw from.
+     * \return The sample.
+     */
+    virtual double GetRandom(RandomGeneratorState& state) const;
+
+    /**
+     * Draw a batch of samples, following the same law as GetRandom.
+     *
+     * The default implementation calls GetRandom in a loop; generators
+     * override it with a block implementation the compiler can vectorize.
+     *
+     * \param out Destination array of at least \p n elements.
+     * \param n Number of samples to draw.
+     */
+    virtual void Fill(double* out, std::size_t n) const;
+
+    /**
+     * Draw a batch of samples from a caller-provided state.
+     *
+     * The default implementation calls GetRandom(state) in a loop.
+     *
+     * \param state The state to draw from.
+     * \param out Destination array of at least \p n elements.
+     * \param n Number of samples to draw.
+     */
+    virtual void Fill(RandomGeneratorState& state, double* out, std::size_t n) const;
+
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this generator, so that runs are reproducible and independent
+     * generators draw from non-overlapping streams.
+     *
+     * Only the draws from the generator's own state, GetRandom() and
+     * Fill(out, n), are affected: the overloads taking a
+     * RandomGeneratorState follow the seed of that state.
+     *
+     * \param stream First stream index to use.
+     * \return The number of stream indices assigned by this generator.
+     */
+    virtual int64_t AssignStreams(int64_t stream);
+
 };
 
 /**
  * \ingroup applications
  * Simple generator using basic statistical values (min, max, mean, stdDev).
  */
-class RandomGeneratorUniform : public RandomGenerator 
+class RandomGeneratorUniform final : public RandomGenerator
 {
 public:
 
@@ -35,15 +170,34 @@ public:
 
     double GetRandom() const override;
 
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
 private:
     double m_min, m_max;
+
+    mutable RandomGeneratorState m_state;
 };
 
 /**
  * \ingroup applications
- * Simple generator using basic statistical values (min, max, mean, stdDev).
+ * Discrete generator over (value, probability) pairs.
+ *
+ * Samples are drawn from a Walker/Vose alias table built at construction:
+ * one uniform draw selects a bin and decides between the bin value and its
+ * alias, whatever the number of bins.
  */
-class RandomGeneratorDist : public RandomGenerator 
+class RandomGeneratorDist final : public RandomGenerator
 {
 public:
 
@@ -53,21 +207,42 @@ public:
 
     double GetRandom() const override;
 
-private:
-    // Random number generator
-    mutable std::default_random_engine m_rng;
+    double GetRandom(RandomGeneratorState& state) const override;
 
-    std::vector<std::pair<double, double>> m_distribution;
-    mutable std::discrete_distribution<> m_discreteDistributionObj;
+    void Fill(double* out, std::size_t n) const override;
 
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
 
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
+private:
+    mutable RandomGeneratorState m_state;
+
+    // Alias table, one entry per bin
+    std::vector<double> m_thresholds;  ///< Probability of keeping the bin value.
+    std::vector<double> m_values;      ///< Value of the bin.
+    std::vector<double> m_aliasValues; ///< Value returned when the bin is not kept.
 };
 
 /**
  * \ingroup applications
- * Simple generator using basic statistical values (min, max, mean, stdDev).
+ * Normal generator truncated to [min, max].
+ *
+ * Out-of-range draws are rejected rather than clamped, so no probability
+ * mass piles up at the bounds. The constructor picks, among three rejection
+ * samplers, the one accepting most often for the window [min, max]:
+ * Ziggurat draws of the whole normal law when the window holds enough of
+ * it, uniform proposals over narrow windows, and Robert's exponential
+ * proposals beyond the mean for windows far in a tail. Each sample then
+ * costs a small, bounded number of uniform draws on average, wherever the
+ * window lies.
  */
-class RandomGeneratorNormal : public RandomGenerator 
+class RandomGeneratorNormal final : public RandomGenerator
 {
 public:
 
@@ -77,9 +252,429 @@ public:
 
     double GetRandom() const override;
 
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
 private:
+    /// Sampler of the standardized window, chosen at construction.
+    enum class Method
+    {
+        CONSTANT,    ///< Degenerate law, always the same value.
+        ZIGGURAT,    ///< Ziggurat draws of the normal law, rejected out of the window.
+        UNIFORM,     ///< Uniform proposals over the window.
+        EXPONENTIAL, ///< Translated exponential proposals beyond the lower bound.
+    };
+
+    /**
+     * Draw a sample of the standardized truncated law.
+     * \param state The state to draw from.
+     * \return The sample, in standard deviations from the mean.
+     */
+    double SampleStandard(RandomGeneratorState& state) const;
+
     double m_min, m_max, m_mean, m_stdDev;
+
+    // Standardized window, mirrored to lie on the positive side when it
+    // does not contain the mean
+    Method m_method;  ///< Sampler of the window.
+    bool m_mirrored;  ///< Whether the window is mirrored.
+    double m_alpha;   ///< Lower bound of the window.
+    double m_beta;    ///< Upper bound of the window.
+    double m_lambda;  ///< Rate of the exponential proposals.
+    double m_closest; ///< Point of the window closest to the mean.
+
+    // Seeded once at construction, kept across calls
+    mutable RandomGeneratorState m_state;
+};
+
+/**
+ * \ingroup applications
+ * Exponential generator of a given mean, truncated to [min, max].
+ *
+ * Samples are drawn by inversion of the survival function over the window,
+ * which truncates the law without rejection: one uniform draw and one
+ * logarithm per sample.
+ */
+class RandomGeneratorExponential final : public RandomGenerator
+{
+public:
+
+    /**
+     * \param mean Mean of the law before truncation, positive.
+     * \param min Lower bound, at least 0.
+     * \param max Upper bound, possibly infinite.
+     */
+    RandomGeneratorExponential(double mean,
+                               double min = 0,
+                               double max = std::numeric_limits<double>::infinity());
+
+    virtual ~RandomGeneratorExponential() = default;
+
+    double GetRandom() const override;
+
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
+private:
+    double m_mean, m_min, m_max;
+
+    // Survival function over the window, computed once
+    double m_survivalMin;  ///< Survival function at min.
+    double m_survivalSpan; ///< Survival function at min, minus at max.
+
+    mutable RandomGeneratorState m_state;
+};
+
+/**
+ * \ingroup applications
+ * Pareto (type I) generator of given scale and shape, truncated to
+ * [min, max].
+ *
+ * Samples are drawn by inversion of the survival function over the window:
+ * one uniform draw and one power per sample.
+ */
+class RandomGeneratorPareto final : public RandomGenerator
+{
+public:
+
+    /**
+     * \param scale Scale, the smallest value of the law, positive.
+     * \param shape Shape (tail index), positive.
+     * \param min Lower bound, at least scale; 0 stands for scale.
+     * \param max Upper bound, possibly infinite.
+     */
+    RandomGeneratorPareto(double scale,
+                          double shape,
+                          double min = 0,
+                          double max = std::numeric_limits<double>::infinity());
+
+    virtual ~RandomGeneratorPareto() = default;
+
+    double GetRandom() const override;
+
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
+private:
+    double m_scale, m_min, m_max;
+
+    double m_exponent;     ///< -1 / shape.
+    double m_survivalMin;  ///< Survival function at min.
+    double m_survivalSpan; ///< Survival function at min, minus at max.
+
+    mutable RandomGeneratorState m_state;
 };
+
+/**
+ * \ingroup applications
+ * Weibull generator of given scale and shape, truncated to [min, max].
+ *
+ * Samples are drawn by inversion of the survival function over the window:
+ * one uniform draw, one logarithm and one power per sample.
+ */
+class RandomGeneratorWeibull final : public RandomGenerator
+{
+public:
+
+    /**
+     * \param scale Scale, positive.
+     * \param shape Shape, positive.
+     * \param min Lower bound, at least 0.
+     * \param max Upper bound, possibly infinite.
+     */
+    RandomGeneratorWeibull(double scale,
+                           double shape,
+                           double min = 0,
+                           double max = std::numeric_limits<double>::infinity());
+
+    virtual ~RandomGeneratorWeibull() = default;
+
+    double GetRandom() const override;
+
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
+private:
+    double m_scale, m_min, m_max;
+
+    double m_exponent;     ///< 1 / shape.
+    double m_survivalMin;  ///< Survival function at min.
+    double m_survivalSpan; ///< Survival function at min, minus at max.
+
+    mutable RandomGeneratorState m_state;
+};
+
+/**
+ * \ingroup applications
+ * Lognormal generator, truncated to [min, max].
+ *
+ * The logarithm of the samples follows the normal law of mean mu and
+ * standard deviation sigma, truncated to [log(min), log(max)] by a
+ * RandomGeneratorNormal built once.
+ */
+class RandomGeneratorLognormal final : public RandomGenerator
+{
+public:
+
+    /**
+     * \param mu Mean of the logarithm of the samples.
+     * \param sigma Standard deviation of the logarithm of the samples, positive.
+     * \param min Lower bound, at least 0.
+     * \param max Upper bound, possibly infinite.
+     */
+    RandomGeneratorLognormal(double mu,
+                             double sigma,
+                             double min = 0,
+                             double max = std::numeric_limits<double>::infinity());
+
+    virtual ~RandomGeneratorLognormal() = default;
+
+    double GetRandom() const override;
+
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
+private:
+    double m_min, m_max;
+    RandomGeneratorNormal m_logarithm; ///< Generator of the logarithm of the samples.
+
+    mutable RandomGeneratorState m_state;
+};
+
+/**
+ * \ingroup applications
+ * Continuous generator following a piecewise-linear empirical CDF, given as
+ * (value, cumulative probability) points.
+ *
+ * The law is a mixture of uniform laws over the segments between points,
+ * so a sample costs one alias table draw, selecting a segment with its
+ * probability, and one uniform draw within the segment. The cumulative
+ * probability of the first point is the probability of its value.
+ */
+class RandomGeneratorEmpirical final : public RandomGenerator
+{
+public:
+
+    /**
+     * \param cdf (value, cumulative probability) points, both non-decreasing,
+     *            the last cumulative probability being 1.
+     */
+    RandomGeneratorEmpirical(const std::vector<std::pair<double, double>>& cdf);
+
+    virtual ~RandomGeneratorEmpirical() = default;
+
+    double GetRandom() const override;
+
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
+private:
+    mutable RandomGeneratorState m_state;
+
+    // Alias table over the segments, one entry per segment
+    std::vector<double> m_thresholds;   ///< Probability of keeping the segment.
+    std::vector<uint32_t> m_aliases;    ///< Segment used when it is not kept.
+    std::vector<double> m_starts;       ///< Lower value of each segment.
+    std::vector<double> m_widths;       ///< Width of each segment.
+};
+
+/**
+ * \ingroup applications
+ * Joint generator of correlated pairs, such as the payload size of a packet
+ * and the time to the next one, following a 2-D histogram.
+ *
+ * The cells of the histogram are flattened into one alias table: a sample
+ * costs three engine outputs, one selecting a cell with its probability and
+ * one per component placing the pair uniformly within the cell, with a
+ * 32-bit resolution. Bins of zero width give exact values.
+ *
+ * It is not a RandomGenerator, whose samples are single values.
+ */
+class RandomGeneratorJoint final
+{
+public:
+
+    /**
+     * \param firstEdges Edges of the bins of the first component,
+     *                   non-decreasing, at least two.
+     * \param secondEdges Edges of the bins of the second component.
+     * \param weights Non-negative weight of each cell, row by row: the
+     *                weight of first bin i and second bin j is at
+     *                i * (secondEdges.size() - 1) + j.
+     */
+    RandomGeneratorJoint(const std::vector<double>& firstEdges,
+                         const std::vector<double>& secondEdges,
+                         const std::vector<double>& weights);
+
+    /// \return A pair drawn from the generator's own state.
+    std::pair<double, double> GetRandom() const;
+
+    /**
+     * Draw a pair from a caller-provided state.
+     * \param state The state to draw from.
+     * \return The pair.
+     */
+    std::pair<double, double> GetRandom(RandomGeneratorState& state) const;
+
+    /**
+     * Reseed the engine from the global seed, the run number and the stream.
+     * \param stream Stream index used to derive the seed.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream);
+
+private:
+    mutable RandomGeneratorState m_state;
+
+    // Alias table over the flattened cells, one entry per cell
+    std::vector<double> m_thresholds;   ///< Probability of keeping the cell.
+    std::vector<uint32_t> m_aliases;    ///< Cell used when it is not kept.
+    std::vector<double> m_firstStarts;  ///< Lower edge of each cell, first component.
+    std::vector<double> m_firstWidths;  ///< Width of each cell, first component.
+    std::vector<double> m_secondStarts; ///< Lower edge of each cell, second component.
+    std::vector<double> m_secondWidths; ///< Width of each cell, second component.
+};
+
+/**
+ * \ingroup applications
+ * Generator replaying a recorded sequence of samples, such as the payload
+ * sizes or inter-packet times of a capture.
+ *
+ * The sample file is memory-mapped read-only and shared by every generator
+ * replaying it, so thousands of instances cost one mapping. Each state
+ * starts at its RandomGeneratorState::start offset, or at a random offset
+ * drawn from its engine, then reads the sequence in order and wraps around
+ * at the end. Two replays recorded together (payload sizes and
+ * inter-packet times of one capture) stay paired when read from states
+ * sharing a start offset.
+ *
+ * The file starts with the 8-byte magic "IOTRPL01" and the number of
+ * samples as a uint64_t, followed by the samples as doubles, in host byte
+ * order. WriteSampleFile writes such a file.
+ */
+class RandomGeneratorReplay final : public RandomGenerator
+{
+public:
+
+    /**
+     * Map a sample file, or share the mapping of a generator already
+     * replaying it.
+     * \param filename Path of the sample file.
+     */
+    RandomGeneratorReplay(const std::string& filename);
+
+    virtual ~RandomGeneratorReplay() = default;
+
+    double GetRandom() const override;
+
+    double GetRandom(RandomGeneratorState& state) const override;
+
+    void Fill(double* out, std::size_t n) const override;
+
+    /**
+     * Copy the next samples of the sequence, wrapping around at the end.
+     * \param state The state to read from.
+     * \param out Destination array of at least \p n elements.
+     * \param n Number of samples to read.
+     */
+    void Fill(RandomGeneratorState& state, double* out, std::size_t n) const override;
+
+    /**
+     * Draw a new start offset from the global seed, the run number and the
+     * stream.
+     * \param stream Stream index used to derive the offset.
+     * \return 1
+     */
+    int64_t AssignStreams(int64_t stream) override;
+
+    /// \return The number of samples of the sequence.
+    std::size_t GetSize() const;
+
+    /**
+     * Write a sample file readable by this class.
+     * \param filename Path of the file to write.
+     * \param samples The sequence of samples.
+     */
+    static void WriteSampleFile(const std::string& filename, const std::vector<double>& samples);
+
+private:
+    /// A read-only mapping of a sample file.
+    class MappedFile;
+
+    /**
+     * Return the position of a state, starting at its start offset, or at a
+     * random one, on first use.
+     * \param state The state.
+     * \return The index of the next sample of the state.
+     */
+    std::size_t GetPosition(RandomGeneratorState& state) const;
+
+    std::shared_ptr<const MappedFile> m_file; ///< Mapping shared between generators.
+    const double* m_samples;                  ///< First sample of the mapping.
+    std::size_t m_size;                       ///< Number of samples.
+    mutable RandomGeneratorState m_state;     ///< Own state.
+};
+
 } // namespace ns3
 
 #endif /* RANDOM_GENERATOR_H */
@@ -1,33 +1,327 @@
 #include "sub-flow.h"
 
+#include <ns3/abort.h>
+#include <ns3/rng-seed-manager.h>
+
+#include <algorithm>
+
 namespace ns3 
 {
 
+namespace
+{
+
+/// Draw from a built-in generator: the class is final, so the call is direct.
+template <class G>
+double
+SampleFrom(const G& generator, RandomGeneratorState* state)
+{
+    return state ? generator.GetRandom(*state) : generator.GetRandom();
+}
+
+/// Draw from a user-defined generator through its virtual interface.
+double
+SampleFrom(const std::shared_ptr<RandomGenerator>& generator, RandomGeneratorState* state)
+{
+    return state ? generator->GetRandom(*state) : generator->GetRandom();
+}
+
+/**
+ * Draw from any generator.
+ * \param generator The generator.
+ * \param state The state to draw from, or nullptr for the generator's own state.
+ * \return The sample.
+ */
+double
+Sample(const SubFlow::Generator& generator, RandomGeneratorState* state)
+{
+    return std::visit([state](const auto& g) { return SampleFrom(g, state); }, generator);
+}
+
+/// Fill a buffer from a built-in generator: the class is final, so the call is direct.
+template <class G>
+void
+FillFrom(const G& generator, RandomGeneratorState& state, double* out, std::size_t n)
+{
+    generator.Fill(state, out, n);
+}
+
+/// Fill a buffer from a user-defined generator through its virtual interface.
+void
+FillFrom(const std::shared_ptr<RandomGenerator>& generator,
+         RandomGeneratorState& state,
+         double* out,
+         std::size_t n)
+{
+    generator->Fill(state, out, n);
+}
+
+/**
+ * Read the next sample of a ring, refilling it from the generator when all
+ * its samples have been read.
+ * \param generator The generator.
+ * \param state The state to draw from.
+ * \param ring The ring of samples drawn ahead from the state.
+ * \return The sample.
+ */
+double
+SampleRing(const SubFlow::Generator& generator,
+           RandomGeneratorState& state,
+           SubFlow::State::Ring& ring)
+{
+    if (ring.next == ring.samples.size())
+    {
+        std::visit(
+            [&](const auto& g) { FillFrom(g, state, ring.samples.data(), ring.samples.size()); },
+            generator);
+        ring.next = 0;
+    }
+    return ring.samples[ring.next++];
+}
+
+/**
+ * Discard the samples drawn ahead in the rings of a state.
+ * \param state The state.
+ */
+void
+ClearRings(SubFlow::State& state)
+{
+    state.payloadSizes.next = SubFlow::State::RING_SIZE;
+    state.interPacketTimes.next = SubFlow::State::RING_SIZE;
+}
+
+/**
+ * Convert a sample to a payload size. Samples outside the range of
+ * uint32_t, whose conversion is undefined, are clamped to it.
+ * \param sample The sample.
+ * \return The payload size, in bytes.
+ */
+uint32_t
+ToPayloadSize(double sample)
+{
+    return sample > 0 ? static_cast<uint32_t>(std::min(sample, 4294967295.0)) : 0;
+}
+
+/**
+ * Give both generator states of a SubFlow state the same replay start
+ * offset, drawn from the payload size engine.
+ * \param state The state.
+ */
+void
+ShareReplayStart(SubFlow::State& state)
+{
+    uint64_t start = static_cast<uint64_t>(state.payloadSize.engine()) << 32;
+    start |= state.payloadSize.engine();
+    state.payloadSize.start = start;
+    state.interPacketTime.start = start;
+}
+
+} // namespace
+
+SubFlow::State::State()
+{
+    payloadSize.Seed(RngSeedManager::GetNextStreamIndex());
+    interPacketTime.Seed(RngSeedManager::GetNextStreamIndex());
+    ShareReplayStart(*this);
+}
+
+void
+SubFlow::State::Seed(uint64_t stream)
+{
+    payloadSize.Seed(stream);
+    interPacketTime.Seed(stream + 1);
+    ShareReplayStart(*this);
+    ClearRings(*this);
+}
+
+SubFlow::Modulation::Modulation()
+{
+    random.Seed(RngSeedManager::GetNextStreamIndex());
+}
+
 SubFlow::SubFlow(
         uint16_t id,
-        std::shared_ptr<RandomGenerator> payloadSizeGenerator, 
-        std::shared_ptr<RandomGenerator> interPacketTimeGenerator):
+        Generator payloadSizeGenerator, 
+        Generator interPacketTimeGenerator):
         m_id(id),
-        m_payloadSizeGenerator(payloadSizeGenerator),
-        m_interPacketTimeGenerator(interPacketTimeGenerator)
+        m_payloadSizeGenerator(std::move(payloadSizeGenerator)),
+        m_interPacketTimeGenerator(std::move(interPacketTimeGenerator))
+{
+}
+
+SubFlow::SubFlow(uint16_t id, RandomGeneratorJoint jointGenerator)
+    : m_id(id),
+      m_payloadSizeGenerator(std::shared_ptr<RandomGenerator>()),
+      m_interPacketTimeGenerator(std::shared_ptr<RandomGenerator>()),
+      m_jointGenerator(std::move(jointGenerator))
 {
 }
 
+SubFlow::SubFlow(uint16_t id, std::vector<ModulationState> states)
+    : m_id(id),
+      m_payloadSizeGenerator(std::shared_ptr<RandomGenerator>()),
+      m_interPacketTimeGenerator(std::shared_ptr<RandomGenerator>()),
+      m_modulationStates(std::move(states))
+{
+    NS_ABORT_MSG_IF(m_modulationStates.empty(), "A modulated SubFlow needs at least one state");
+    for (const auto& state : m_modulationStates)
+    {
+        NS_ABORT_MSG_IF(!state.packets || state.packets->IsModulated(),
+                        "The packets of a state must come from a SubFlow that is not modulated");
+    }
+}
+
 uint16_t
-SubFlow::GetId() 
+SubFlow::GetId() const
 {
     return m_id;
 }
 
+bool
+SubFlow::IsModulated() const
+{
+    return !m_modulationStates.empty();
+}
+
+double
+SubFlow::StartModulation(Modulation& modulation) const
+{
+    modulation.state = 0;
+    return Sample(m_modulationStates[0].dwellTime, &modulation.random);
+}
+
+double
+SubFlow::NextModulationState(Modulation& modulation) const
+{
+    const ModulationState& current = m_modulationStates[modulation.state];
+    modulation.state = static_cast<uint32_t>(current.transitions.GetRandom(modulation.random));
+    return Sample(m_modulationStates[modulation.state].dwellTime, &modulation.random);
+}
+
+SubFlow::State&
+SubFlow::GetModulatedState(State& state, uint32_t modulation) const
+{
+    if (state.modulationStates.size() != m_modulationStates.size())
+    {
+        state.modulationStates.resize(m_modulationStates.size());
+    }
+    return state.modulationStates[modulation];
+}
+
+void
+SubFlow::ClaimRings(State& state) const
+{
+    if (state.owner != this)
+    {
+        ClearRings(state);
+        state.owner = this;
+    }
+}
+
 uint32_t
 SubFlow::GetPayloadSize() const
 {
-    return m_payloadSizeGenerator->GetRandom();
+    if (IsModulated())
+    {
+        // Without a State, the SubFlow stays in its first state
+        return m_modulationStates[0].packets->GetPayloadSize();
+    }
+    if (m_jointGenerator)
+    {
+        return ToPayloadSize(m_jointGenerator->GetRandom().first);
+    }
+    return ToPayloadSize(Sample(m_payloadSizeGenerator, nullptr));
 }
 
 double
 SubFlow::GetInterPacketTime() const
 {
-    return m_interPacketTimeGenerator->GetRandom();
+    if (IsModulated())
+    {
+        // Without a State, the SubFlow stays in its first state
+        return m_modulationStates[0].packets->GetInterPacketTime();
+    }
+    if (m_jointGenerator)
+    {
+        return m_jointGenerator->GetRandom().second;
+    }
+    return Sample(m_interPacketTimeGenerator, nullptr);
+}
+
+uint32_t
+SubFlow::GetPayloadSize(State& state, uint32_t modulation) const
+{
+    if (IsModulated())
+    {
+        return m_modulationStates[modulation].packets->GetPayloadSize(
+            GetModulatedState(state, modulation));
+    }
+    if (m_jointGenerator)
+    {
+        return ToPayloadSize(m_jointGenerator->GetRandom(state.payloadSize).first);
+    }
+    ClaimRings(state);
+    return ToPayloadSize(SampleRing(m_payloadSizeGenerator, state.payloadSize, state.payloadSizes));
+}
+
+double
+SubFlow::GetInterPacketTime(State& state, uint32_t modulation) const
+{
+    if (IsModulated())
+    {
+        return m_modulationStates[modulation].packets->GetInterPacketTime(
+            GetModulatedState(state, modulation));
+    }
+    if (m_jointGenerator)
+    {
+        return m_jointGenerator->GetRandom(state.payloadSize).second;
+    }
+    ClaimRings(state);
+    return SampleRing(m_interPacketTimeGenerator, state.interPacketTime, state.interPacketTimes);
+}
+
+SubFlow::NextPacket
+SubFlow::GetNextPacket(State& state, uint32_t modulation) const
+{
+    if (IsModulated())
+    {
+        return m_modulationStates[modulation].packets->GetNextPacket(
+            GetModulatedState(state, modulation));
+    }
+    if (m_jointGenerator)
+    {
+        // One draw for both, from the payload size state
+        std::pair<double, double> pair = m_jointGenerator->GetRandom(state.payloadSize);
+        return {ToPayloadSize(pair.first), pair.second};
+    }
+    ClaimRings(state);
+    return {ToPayloadSize(
+                SampleRing(m_payloadSizeGenerator, state.payloadSize, state.payloadSizes)),
+            SampleRing(m_interPacketTimeGenerator, state.interPacketTime, state.interPacketTimes)};
+}
+
+int64_t
+SubFlow::AssignStreams(State& state, int64_t stream) const
+{
+    if (IsModulated())
+    {
+        int64_t currentStream = stream;
+        for (uint32_t i = 0; i < m_modulationStates.size(); ++i)
+        {
+            currentStream += m_modulationStates[i].packets->AssignStreams(
+                GetModulatedState(state, i),
+                currentStream);
+        }
+        return (currentStream - stream);
+    }
+    state.Seed(stream);
+    return 2;
+}
+
+int64_t
+SubFlow::AssignStreams(Modulation& modulation, int64_t stream)
+{
+    modulation.random.Seed(stream);
+    return 1;
 }
 } // namespace ns3
\ No newline at end of file
@@ -1,7 +1,11 @@
 #ifndef PACKET_CLASS
 #define PACKET_CLASS
+#include <array>
 #include <cstdint> 
 #include <memory>
+#include <optional>
+#include <variant>
+#include <vector>
 #include "random-generator.h"
 namespace ns3
 {
@@ -9,29 +13,239 @@ namespace ns3
 /**
  * \ingroup applications
  * Modelize a packet class.
+ *
+ * The built-in generators are stored by value and sampled without virtual
+ * dispatch. Any other RandomGenerator is accepted through a shared pointer
+ * and sampled through its virtual interface.
+ *
+ * The payload sizes and inter-packet times are drawn from two independent
+ * generators, or together from a RandomGeneratorJoint when they are
+ * correlated.
+ *
+ * A Markov-modulated SubFlow alternates between states, such as the idle
+ * and motion phases of a camera, each with its own packet generators, dwell
+ * time and row of the transition matrix. The generators of every state are
+ * built once with the SubFlow; the current state is kept in the caller's
+ * Modulation, and a state change only draws the next state and its dwell
+ * time. Each State keeps one nested State per modulation state, so that
+ * the sequence drawn in a state resumes where it stopped.
+ *
+ * A SubFlow is meant to be shared: the overloads taking a State draw from
+ * the caller's state, so any number of applications can use one SubFlow
+ * and its tables while each keeps a State of under 400 bytes per user,
+ * typically per connection, most of it samples drawn ahead. A State
+ * passed to another SubFlow discards them.
  */
 class SubFlow 
 {
 public:
 
+    /// A generator of the SubFlow: a built-in generator or a user-defined one.
+    using Generator = std::variant<RandomGeneratorUniform,
+                                   RandomGeneratorNormal,
+                                   RandomGeneratorDist,
+                                   RandomGeneratorReplay,
+                                   RandomGeneratorExponential,
+                                   RandomGeneratorPareto,
+                                   RandomGeneratorWeibull,
+                                   RandomGeneratorLognormal,
+                                   RandomGeneratorEmpirical,
+                                   std::shared_ptr<RandomGenerator>>;
+
+    /**
+     * Per-user state of a SubFlow: one generator state per generator. Both
+     * generator states share their replay start offset, so that a payload
+     * size and an inter-packet time replayed from one capture stay paired.
+     *
+     * Each generator state feeds a ring of samples, refilled by blocks of
+     * RING_SIZE with Fill and read in order, so that most packets cost an
+     * array read. The rings only reorder the draws in time: each generator
+     * still gives its own sequence, and replayed pairs stay paired. Joint
+     * generators draw their pairs directly.
+     */
+    struct State
+    {
+        /// Number of samples drawn by each refill of a ring.
+        static constexpr std::size_t RING_SIZE = 16;
+
+        /// Samples drawn ahead from a generator state.
+        struct Ring
+        {
+            std::array<double, RING_SIZE> samples{}; ///< Samples, read in order.
+            std::size_t next{RING_SIZE};             ///< Index of the next sample to read.
+        };
+
+        /// Seed both generator states from the next free stream indices.
+        State();
+
+        /**
+         * Seed both generator states from fixed streams, discarding the
+         * samples drawn ahead.
+         * \param stream Stream of the payload size state; the inter-packet
+         *               time state uses the next one.
+         */
+        void Seed(uint64_t stream);
+
+        RandomGeneratorState payloadSize;     ///< State of the payload size generator.
+        RandomGeneratorState interPacketTime; ///< State of the inter-packet time generator.
+        Ring payloadSizes;                    ///< Payload sizes drawn ahead.
+        Ring interPacketTimes;                ///< Inter-packet times drawn ahead.
+        const SubFlow* owner{nullptr};        ///< SubFlow which filled the rings.
+        std::vector<State> modulationStates;  ///< One state per state of a Markov-modulated SubFlow.
+    };
+
+    /**
+     * Current state of a Markov-modulated SubFlow, shared by all the users
+     * of an application.
+     */
+    struct Modulation
+    {
+        /// Seed the engine from the next free stream index.
+        Modulation();
+
+        uint32_t state{0};           ///< Index of the current state.
+        RandomGeneratorState random; ///< State drawing the transitions and dwell times.
+    };
+
+    /// State of a Markov-modulated SubFlow.
+    struct ModulationState
+    {
+        std::shared_ptr<SubFlow> packets; ///< Generators of the packets sent in the state.
+        Generator dwellTime;              ///< Time spent in the state, in seconds.
+        RandomGeneratorDist transitions;  ///< Next state, drawn from the row of the state.
+    };
+
+    /// Payload size of a packet and time to the next packet of the SubFlow.
+    struct NextPacket
+    {
+        uint32_t payloadSize;   ///< Payload size, in bytes.
+        double interPacketTime; ///< Time to the next packet, in seconds.
+    };
+
     SubFlow(
         uint16_t id,
-        std::shared_ptr<RandomGenerator> payloadSizeGenerator, 
-        std::shared_ptr<RandomGenerator> interPacketTimeGenerator);
+        Generator payloadSizeGenerator, 
+        Generator interPacketTimeGenerator);
+
+    /**
+     * Build a SubFlow drawing each (payload size, inter-packet time) pair
+     * from a joint generator.
+     * \param id The SubFlow id.
+     * \param jointGenerator Generator of the pairs.
+     */
+    SubFlow(uint16_t id, RandomGeneratorJoint jointGenerator);
+
+    /**
+     * Build a Markov-modulated SubFlow, starting in the first state.
+     * \param id The SubFlow id.
+     * \param states The states, whose transitions draw state indices.
+     */
+    SubFlow(uint16_t id, std::vector<ModulationState> states);
 
     virtual ~SubFlow() = default;
 
-    //bytes
+    /**
+     * Draw a payload size from the generators' own states, which every user
+     * of the SubFlow shares and which AssignStreams(State&, int64_t) does
+     * not reseed. Applications draw from a State instead.
+     * \return The payload size, in bytes.
+     */
     uint32_t GetPayloadSize() const;
 
-    //seconds
+    /**
+     * Draw an inter-packet time from the generators' own states, like
+     * GetPayloadSize().
+     * \return The inter-packet time, in seconds.
+     */
     double GetInterPacketTime() const;
+
+    /**
+     * Draw a payload size from a caller-provided state.
+     * \param state The state to draw from.
+     * \param modulation Current state of a Markov-modulated SubFlow.
+     * \return The payload size, in bytes.
+     */
+    uint32_t GetPayloadSize(State& state, uint32_t modulation = 0) const;
+
+    /**
+     * Draw an inter-packet time from a caller-provided state.
+     * \param state The state to draw from.
+     * \param modulation Current state of a Markov-modulated SubFlow.
+     * \return The inter-packet time, in seconds.
+     */
+    double GetInterPacketTime(State& state, uint32_t modulation = 0) const;
+
+    /**
+     * Draw the payload size of a packet and the time to the next one from a
+     * caller-provided state. With a joint generator, both come from a
+     * single draw and are correlated; GetPayloadSize and GetInterPacketTime
+     * would each draw a pair and keep one half of it.
+     * \param state The state to draw from.
+     * \param modulation Current state of a Markov-modulated SubFlow.
+     * \return The payload size and the inter-packet time.
+     */
+    NextPacket GetNextPacket(State& state, uint32_t modulation = 0) const;
     
-    uint16_t GetId();
+    uint16_t GetId() const;
+
+    /// \return true if the SubFlow is Markov-modulated.
+    bool IsModulated() const;
+
+    /**
+     * Put a modulation in the first state of a Markov-modulated SubFlow.
+     * \param modulation The modulation.
+     * \return The dwell time in the first state, in seconds.
+     */
+    double StartModulation(Modulation& modulation) const;
+
+    /**
+     * Move a modulation to the next state of a Markov-modulated SubFlow,
+     * drawn from the transition row of its current state. No generator is
+     * rebuilt.
+     * \param modulation The modulation.
+     * \return The dwell time in the new state, in seconds.
+     */
+    double NextModulationState(Modulation& modulation) const;
+
+    /**
+     * Assign fixed random variable streams to a state, and to its nested
+     * states if the SubFlow is Markov-modulated.
+     * \param state The state.
+     * \param stream First stream index to use.
+     * \return The number of stream indices assigned: two per State.
+     */
+    int64_t AssignStreams(State& state, int64_t stream) const;
+
+    /**
+     * Assign a fixed random variable stream to a modulation.
+     * \param modulation The modulation.
+     * \param stream Stream index to use.
+     * \return 1
+     */
+    static int64_t AssignStreams(Modulation& modulation, int64_t stream);
+
 protected: 
+    /**
+     * Return the nested state of a modulation state, creating the nested
+     * states on first use.
+     * \param state The state of the SubFlow.
+     * \param modulation The modulation state.
+     * \return The nested state.
+     */
+    State& GetModulatedState(State& state, uint32_t modulation) const;
+
+    /**
+     * Discard the samples drawn ahead in the rings of a state if another
+     * SubFlow filled them.
+     * \param state The state.
+     */
+    void ClaimRings(State& state) const;
+
     uint16_t m_id;
-    std::shared_ptr<RandomGenerator> m_payloadSizeGenerator;
-    std::shared_ptr<RandomGenerator> m_interPacketTimeGenerator;
+    Generator m_payloadSizeGenerator;
+    Generator m_interPacketTimeGenerator;
+    std::optional<RandomGeneratorJoint> m_jointGenerator; ///< Joint generator, if any.
+    std::vector<ModulationState> m_modulationStates;      ///< States, if Markov-modulated.
 };
 
 } // namespace ns3
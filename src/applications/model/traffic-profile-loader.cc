@@ -0,0 +1,1373 @@
+#include "traffic-profile-loader.h"
+
+#include <ns3/abort.h>
+#include <ns3/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE("TrafficProfileLoader");
+
+namespace ns3
+{
+
+namespace
+{
+
+/// A parsed JSON value.
+struct JsonValue
+{
+    /// Type of a JSON value.
+    enum Type
+    {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    Type type{NUL};                                          ///< Type of the value.
+    bool boolean{false};                                     ///< Value of a boolean.
+    double number{0};                                        ///< Value of a number.
+    std::string string;                                      ///< Value of a string.
+    std::vector<JsonValue> array;                            ///< Elements of an array.
+    std::vector<std::pair<std::string, JsonValue>> object;   ///< Members of an object, in file order.
+    std::size_t line{0};                                     ///< Line of the value in the file.
+
+    /**
+     * Find a member of an object.
+     * \param key The member name.
+     * \return The member, or nullptr if missing.
+     */
+    const JsonValue* Find(const std::string& key) const
+    {
+        for (const auto& member : object)
+        {
+            if (member.first == key)
+            {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+/// Name of a JSON type, for error messages.
+const char*
+TypeName(JsonValue::Type type)
+{
+    switch (type)
+    {
+    case JsonValue::NUL:
+        return "null";
+    case JsonValue::BOOLEAN:
+        return "a boolean";
+    case JsonValue::NUMBER:
+        return "a number";
+    case JsonValue::STRING:
+        return "a string";
+    case JsonValue::ARRAY:
+        return "an array";
+    case JsonValue::OBJECT:
+        return "an object";
+    }
+    return "unknown";
+}
+
+/**
+ * Recursive descent parser for the subset of JSON used by profiles, which
+ * is all of JSON except \\u escapes outside the Basic Multilingual Plane.
+ */
+class JsonParser
+{
+public:
+    /**
+     * \param text The document.
+     * \param filename Path of the document, for error messages.
+     */
+    JsonParser(const std::string& text, const std::string& filename)
+        : m_text(text),
+          m_filename(filename)
+    {
+    }
+
+    /**
+     * Parse the whole document.
+     * \return The root value.
+     */
+    JsonValue Parse()
+    {
+        JsonValue root = ParseValue(0);
+        SkipWhitespace();
+        if (m_pos != m_text.size())
+        {
+            Fail("unexpected data after the root value");
+        }
+        return root;
+    }
+
+private:
+    /// Maximum nesting of arrays and objects.
+    static constexpr int MAX_DEPTH = 64;
+
+    /**
+     * Abort with the current line.
+     * \param message The error.
+     */
+    [[noreturn]] void Fail(const std::string& message) const
+    {
+        NS_FATAL_ERROR(m_filename << ":" << m_line << ": " << message);
+    }
+
+    void SkipWhitespace()
+    {
+        while (m_pos < m_text.size())
+        {
+            char c = m_text[m_pos];
+            if (c == '\n')
+            {
+                m_line++;
+            }
+            else if (c != ' ' && c != '\t' && c != '\r')
+            {
+                return;
+            }
+            m_pos++;
+        }
+    }
+
+    /**
+     * Consume an expected character.
+     * \param expected The character.
+     */
+    void Expect(char expected)
+    {
+        SkipWhitespace();
+        if (m_pos >= m_text.size() || m_text[m_pos] != expected)
+        {
+            Fail(std::string("expected '") + expected + "'");
+        }
+        m_pos++;
+    }
+
+    JsonValue ParseValue(int depth)
+    {
+        SkipWhitespace();
+        if (m_pos >= m_text.size())
+        {
+            Fail("unexpected end of file");
+        }
+        if (depth > MAX_DEPTH)
+        {
+            Fail("too deeply nested");
+        }
+
+        JsonValue value;
+        value.line = m_line;
+        char c = m_text[m_pos];
+        if (c == '{')
+        {
+            ParseObject(value, depth);
+        }
+        else if (c == '[')
+        {
+            ParseArray(value, depth);
+        }
+        else if (c == '"')
+        {
+            value.type = JsonValue::STRING;
+            value.string = ParseString();
+        }
+        else if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            value.type = JsonValue::NUMBER;
+            value.number = ParseNumber();
+        }
+        else if (m_text.compare(m_pos, 4, "true") == 0)
+        {
+            value.type = JsonValue::BOOLEAN;
+            value.boolean = true;
+            m_pos += 4;
+        }
+        else if (m_text.compare(m_pos, 5, "false") == 0)
+        {
+            value.type = JsonValue::BOOLEAN;
+            m_pos += 5;
+        }
+        else if (m_text.compare(m_pos, 4, "null") == 0)
+        {
+            m_pos += 4;
+        }
+        else
+        {
+            Fail(std::string("unexpected character '") + c + "'");
+        }
+        return value;
+    }
+
+    void ParseObject(JsonValue& value, int depth)
+    {
+        value.type = JsonValue::OBJECT;
+        m_pos++;
+        SkipWhitespace();
+        if (m_pos < m_text.size() && m_text[m_pos] == '}')
+        {
+            m_pos++;
+            return;
+        }
+        while (true)
+        {
+            SkipWhitespace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"')
+            {
+                Fail("expected a member name");
+            }
+            std::string key = ParseString();
+            if (value.Find(key))
+            {
+                Fail("duplicate key '" + key + "'");
+            }
+            Expect(':');
+            value.object.emplace_back(key, ParseValue(depth + 1));
+
+            SkipWhitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',')
+            {
+                m_pos++;
+                continue;
+            }
+            Expect('}');
+            return;
+        }
+    }
+
+    void ParseArray(JsonValue& value, int depth)
+    {
+        value.type = JsonValue::ARRAY;
+        m_pos++;
+        SkipWhitespace();
+        if (m_pos < m_text.size() && m_text[m_pos] == ']')
+        {
+            m_pos++;
+            return;
+        }
+        while (true)
+        {
+            value.array.push_back(ParseValue(depth + 1));
+
+            SkipWhitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',')
+            {
+                m_pos++;
+                continue;
+            }
+            Expect(']');
+            return;
+        }
+    }
+
+    std::string ParseString()
+    {
+        std::string result;
+        m_pos++;
+        while (true)
+        {
+            if (m_pos >= m_text.size())
+            {
+                Fail("unterminated string");
+            }
+            char c = m_text[m_pos++];
+            if (c == '"')
+            {
+                return result;
+            }
+            if (c == '\n' || static_cast<unsigned char>(c) < 0x20)
+            {
+                Fail("control character in string");
+            }
+            if (c != '\\')
+            {
+                result += c;
+                continue;
+            }
+
+            if (m_pos >= m_text.size())
+            {
+                Fail("unterminated string");
+            }
+            char escape = m_text[m_pos++];
+            switch (escape)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                result += escape;
+                break;
+            case 'b':
+                result += '\b';
+                break;
+            case 'f':
+                result += '\f';
+                break;
+            case 'n':
+                result += '\n';
+                break;
+            case 'r':
+                result += '\r';
+                break;
+            case 't':
+                result += '\t';
+                break;
+            case 'u':
+                AppendCodePoint(result, ParseHex4());
+                break;
+            default:
+                Fail(std::string("invalid escape '\\") + escape + "'");
+            }
+        }
+    }
+
+    unsigned ParseHex4()
+    {
+        if (m_pos + 4 > m_text.size())
+        {
+            Fail("truncated \\u escape");
+        }
+        unsigned codePoint = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            char c = m_text[m_pos++];
+            codePoint <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                codePoint |= c - '0';
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                codePoint |= c - 'a' + 10;
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                codePoint |= c - 'A' + 10;
+            }
+            else
+            {
+                Fail("invalid \\u escape");
+            }
+        }
+        return codePoint;
+    }
+
+    /// Append a Basic Multilingual Plane code point as UTF-8.
+    static void AppendCodePoint(std::string& out, unsigned codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            out += static_cast<char>(0xc0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3f));
+        }
+        else
+        {
+            out += static_cast<char>(0xe0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (codePoint & 0x3f));
+        }
+    }
+
+    double ParseNumber()
+    {
+        // Validate the JSON number grammar, then let strtod convert it
+        std::size_t start = m_pos;
+        if (m_text[m_pos] == '-')
+        {
+            m_pos++;
+        }
+        if (!SkipDigits())
+        {
+            Fail("invalid number");
+        }
+        if (m_pos < m_text.size() && m_text[m_pos] == '.')
+        {
+            m_pos++;
+            if (!SkipDigits())
+            {
+                Fail("invalid number");
+            }
+        }
+        if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E'))
+        {
+            m_pos++;
+            if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-'))
+            {
+                m_pos++;
+            }
+            if (!SkipDigits())
+            {
+                Fail("invalid number");
+            }
+        }
+        return std::strtod(m_text.substr(start, m_pos - start).c_str(), nullptr);
+    }
+
+    /// \return true if at least one digit was skipped.
+    bool SkipDigits()
+    {
+        std::size_t start = m_pos;
+        while (m_pos < m_text.size() && m_text[m_pos] >= '0' && m_text[m_pos] <= '9')
+        {
+            m_pos++;
+        }
+        return m_pos > start;
+    }
+
+    const std::string& m_text;    ///< The document.
+    const std::string& m_filename; ///< Path of the document.
+    std::size_t m_pos{0};         ///< Position of the next character.
+    std::size_t m_line{1};        ///< Current line.
+};
+
+/// Largest payload size, in bytes.
+constexpr double LARGEST_PAYLOAD_SIZE = std::numeric_limits<uint32_t>::max();
+
+/// Kind of generator of a profile.
+enum class GeneratorType
+{
+    UNIFORM,
+    NORMAL,
+    DIST,
+    REPLAY,
+    EXPONENTIAL,
+    PARETO,
+    WEIBULL,
+    LOGNORMAL,
+    EMPIRICAL
+};
+
+/// Validated parameters of a generator.
+struct GeneratorSpec
+{
+    GeneratorType type{GeneratorType::UNIFORM};             ///< Kind of generator.
+    double min{0};                                          ///< Lower bound.
+    double max{0};                                          ///< Upper bound.
+    double mean{0};                                         ///< Mean of a normal or exponential law.
+    double stdDev{0};                                       ///< Standard deviation of a normal law.
+    double scale{0};                                        ///< Scale of a Pareto or Weibull law.
+    double shape{0};                                        ///< Shape of a Pareto or Weibull law.
+    double mu{0};                                           ///< Mean of the logarithm of a lognormal law.
+    double sigma{0};                                        ///< Standard deviation of the logarithm of a lognormal law.
+    std::vector<std::pair<double, double>> distribution;    ///< (value, probability) or (value, cumulative) pairs.
+    std::string file;                                       ///< Replay sample file.
+};
+
+/// Validated parameters of a joint (payload size, inter-packet time) histogram.
+struct JointSpec
+{
+    std::vector<double> payloadSizeEdges;     ///< Edges of the payload size bins.
+    std::vector<double> interPacketTimeEdges; ///< Edges of the inter-packet time bins.
+    std::vector<double> weights;              ///< Weight of each cell, row by row.
+};
+
+/// Validated packet generators of a sub-flow or of a state.
+struct PacketsSpec
+{
+    bool joint{false};                ///< Whether the packets use a joint histogram.
+    GeneratorSpec payloadSize;        ///< Payload size generator.
+    GeneratorSpec interPacketTimes;   ///< Inter-packet time generator.
+    JointSpec jointHistogram;         ///< Joint histogram, for joint packets.
+};
+
+/// Validated parameters of a state of a Markov-modulated sub-flow.
+struct ModulationStateSpec
+{
+    PacketsSpec packets;              ///< Packets sent in the state.
+    GeneratorSpec dwellTime;          ///< Time spent in the state.
+    std::vector<double> transitions;  ///< Weight of the transition to each state.
+};
+
+/// Validated parameters of a sub-flow.
+struct SubFlowSpec
+{
+    uint16_t id{0};                           ///< SubFlow id.
+    PacketsSpec packets;                      ///< Packets, for sub-flows that are not modulated.
+    std::vector<ModulationStateSpec> states;  ///< States, for Markov-modulated sub-flows.
+};
+
+/// A validated profile.
+using ProfileSpec = std::vector<SubFlowSpec>;
+
+/// Edit distance between two keys, to suggest the intended one.
+std::size_t
+EditDistance(const std::string& a, const std::string& b)
+{
+    std::vector<std::size_t> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); j++)
+    {
+        row[j] = j;
+    }
+    for (std::size_t i = 1; i <= a.size(); i++)
+    {
+        std::size_t diagonal = row[0];
+        row[0] = i;
+        for (std::size_t j = 1; j <= b.size(); j++)
+        {
+            std::size_t above = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1])});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+/**
+ * Checks a parsed document against the profile schema, reporting the file,
+ * line and path of the first error.
+ */
+class ProfileValidator
+{
+public:
+    /**
+     * \param filename Path of the profile.
+     */
+    ProfileValidator(const std::string& filename)
+        : m_filename(filename)
+    {
+    }
+
+    /**
+     * Validate a profile.
+     * \param root The root of the document.
+     * \return The validated profile.
+     */
+    ProfileSpec Validate(const JsonValue& root) const
+    {
+        CheckObject(root, "profile", {"sub-flows"});
+        const JsonValue& subFlows = Member(root, "profile", "sub-flows", JsonValue::ARRAY);
+        if (subFlows.array.empty())
+        {
+            Fail(subFlows, "sub-flows", "the profile has no sub-flow");
+        }
+
+        ProfileSpec profile;
+        std::set<uint16_t> ids;
+        for (std::size_t i = 0; i < subFlows.array.size(); i++)
+        {
+            const JsonValue& entry = subFlows.array[i];
+            std::string path = "sub-flows[" + std::to_string(i) + "]";
+            CheckObject(entry,
+                        path,
+                        {"id"},
+                        {"payload-size", "inter-packet-times", "joint", "markov"});
+
+            SubFlowSpec subFlow;
+            const JsonValue& id = Member(entry, path, "id", JsonValue::NUMBER);
+            if (id.number < 0 || id.number > 65535 || id.number != std::floor(id.number))
+            {
+                Fail(id, path + ".id", "must be an integer between 0 and 65535");
+            }
+            subFlow.id = static_cast<uint16_t>(id.number);
+            if (!ids.insert(subFlow.id).second)
+            {
+                Fail(id, path + ".id", "duplicate sub-flow id " + std::to_string(subFlow.id));
+            }
+
+            if (const JsonValue* markov = entry.Find("markov"))
+            {
+                if (entry.Find("payload-size") || entry.Find("inter-packet-times") ||
+                    entry.Find("joint"))
+                {
+                    Fail(*markov,
+                         path,
+                         "'markov' replaces 'payload-size', 'inter-packet-times' and 'joint'");
+                }
+                subFlow.states = ValidateMarkov(Member(entry, path, "markov", JsonValue::OBJECT),
+                                                path + ".markov");
+            }
+            else
+            {
+                subFlow.packets = ValidatePackets(entry, path);
+            }
+            profile.push_back(std::move(subFlow));
+        }
+        return profile;
+    }
+
+private:
+    /**
+     * Abort on a schema error.
+     * \param value The offending value.
+     * \param path Path of the value in the document.
+     * \param message The error.
+     */
+    [[noreturn]] void Fail(const JsonValue& value,
+                           const std::string& path,
+                           const std::string& message) const
+    {
+        NS_FATAL_ERROR(m_filename << ":" << value.line << ": " << path << ": " << message);
+    }
+
+    /**
+     * Check that a value is an object holding only known keys, and all the
+     * required ones.
+     * \param value The value.
+     * \param path Path of the value in the document.
+     * \param keys The required keys of the object.
+     * \param optionalKeys The optional keys of the object.
+     */
+    void CheckObject(const JsonValue& value,
+                     const std::string& path,
+                     const std::vector<std::string>& keys,
+                     const std::vector<std::string>& optionalKeys = {}) const
+    {
+        if (value.type != JsonValue::OBJECT)
+        {
+            Fail(value, path, std::string("expected an object, found ") + TypeName(value.type));
+        }
+        std::vector<std::string> known(keys);
+        known.insert(known.end(), optionalKeys.begin(), optionalKeys.end());
+        for (const auto& member : value.object)
+        {
+            if (std::find(known.begin(), known.end(), member.first) == known.end())
+            {
+                Fail(member.second,
+                     path,
+                     "unknown key '" + member.first + "'" + Suggest(member.first, known));
+            }
+        }
+        for (const auto& key : keys)
+        {
+            if (!value.Find(key))
+            {
+                Fail(value, path, "missing key '" + key + "'");
+            }
+        }
+    }
+
+    /**
+     * Return a member of an object, checking its type.
+     * \param object The object.
+     * \param path Path of the object in the document.
+     * \param key The member name.
+     * \param type The expected type.
+     * \return The member.
+     */
+    const JsonValue& Member(const JsonValue& object,
+                            const std::string& path,
+                            const std::string& key,
+                            JsonValue::Type type) const
+    {
+        const JsonValue* member = object.Find(key);
+        if (!member)
+        {
+            Fail(object, path, "missing key '" + key + "'");
+        }
+        if (member->type != type)
+        {
+            Fail(*member,
+                 path + "." + key,
+                 std::string("expected ") + TypeName(type) + ", found " + TypeName(member->type));
+        }
+        return *member;
+    }
+
+    /**
+     * Return a positive number member of an object.
+     * \param object The object.
+     * \param path Path of the object in the document.
+     * \param key The member name.
+     * \return The number.
+     */
+    double Positive(const JsonValue& object, const std::string& path, const std::string& key) const
+    {
+        const JsonValue& member = Member(object, path, key, JsonValue::NUMBER);
+        if (!(member.number > 0))
+        {
+            Fail(member, path + "." + key, "must be positive");
+        }
+        return member.number;
+    }
+
+    /// \return A " (did you mean ...)" hint, or an empty string.
+    static std::string Suggest(const std::string& word, const std::vector<std::string>& candidates)
+    {
+        for (const auto& candidate : candidates)
+        {
+            bool prefix = word.compare(0, candidate.size(), candidate) == 0 ||
+                          candidate.compare(0, word.size(), word) == 0;
+            if (prefix || EditDistance(word, candidate) <= 2)
+            {
+                return " (did you mean '" + candidate + "'?)";
+            }
+        }
+        return "";
+    }
+
+    GeneratorSpec ValidateGenerator(const JsonValue& value, const std::string& path) const
+    {
+        static const std::vector<std::string> types{"uniform",
+                                                    "normal",
+                                                    "dist",
+                                                    "replay",
+                                                    "exponential",
+                                                    "pareto",
+                                                    "weibull",
+                                                    "lognormal",
+                                                    "empirical"};
+
+        const JsonValue& type = Member(value, path, "type", JsonValue::STRING);
+        GeneratorSpec spec;
+        if (type.string == "uniform")
+        {
+            spec.type = GeneratorType::UNIFORM;
+            CheckObject(value, path, {"type", "min", "max"});
+            ValidateBounds(spec, value, path);
+        }
+        else if (type.string == "normal")
+        {
+            spec.type = GeneratorType::NORMAL;
+            CheckObject(value, path, {"type", "min", "max", "mean", "std-dev"});
+            ValidateBounds(spec, value, path);
+            spec.mean = Member(value, path, "mean", JsonValue::NUMBER).number;
+            spec.stdDev = Positive(value, path, "std-dev");
+        }
+        else if (type.string == "dist")
+        {
+            spec.type = GeneratorType::DIST;
+            CheckObject(value, path, {"type", "distribution"});
+            ValidateDistribution(spec, Member(value, path, "distribution", JsonValue::ARRAY),
+                                 path + ".distribution");
+        }
+        else if (type.string == "replay")
+        {
+            spec.type = GeneratorType::REPLAY;
+            CheckObject(value, path, {"type", "file"});
+            const JsonValue& file = Member(value, path, "file", JsonValue::STRING);
+            if (file.string.empty())
+            {
+                Fail(file, path + ".file", "must not be empty");
+            }
+            spec.file = ResolvePath(file.string);
+        }
+        else if (type.string == "exponential")
+        {
+            spec.type = GeneratorType::EXPONENTIAL;
+            CheckObject(value, path, {"type", "mean"}, {"min", "max"});
+            spec.mean = Positive(value, path, "mean");
+            ValidateOptionalBounds(spec, value, path, 0, "0");
+        }
+        else if (type.string == "pareto")
+        {
+            spec.type = GeneratorType::PARETO;
+            CheckObject(value, path, {"type", "scale", "shape"}, {"min", "max"});
+            spec.scale = Positive(value, path, "scale");
+            spec.shape = Positive(value, path, "shape");
+            ValidateOptionalBounds(spec, value, path, spec.scale, "scale");
+        }
+        else if (type.string == "weibull")
+        {
+            spec.type = GeneratorType::WEIBULL;
+            CheckObject(value, path, {"type", "scale", "shape"}, {"min", "max"});
+            spec.scale = Positive(value, path, "scale");
+            spec.shape = Positive(value, path, "shape");
+            ValidateOptionalBounds(spec, value, path, 0, "0");
+        }
+        else if (type.string == "lognormal")
+        {
+            spec.type = GeneratorType::LOGNORMAL;
+            CheckObject(value, path, {"type", "mu", "sigma"}, {"min", "max"});
+            spec.mu = Member(value, path, "mu", JsonValue::NUMBER).number;
+            spec.sigma = Positive(value, path, "sigma");
+            ValidateOptionalBounds(spec, value, path, 0, "0");
+        }
+        else if (type.string == "empirical")
+        {
+            spec.type = GeneratorType::EMPIRICAL;
+            CheckObject(value, path, {"type", "cdf"});
+            ValidateCdf(spec, Member(value, path, "cdf", JsonValue::ARRAY), path + ".cdf");
+        }
+        else
+        {
+            Fail(type, path + ".type", "unknown type '" + type.string + "'" + Suggest(type.string, types));
+        }
+        return spec;
+    }
+
+    void ValidateBounds(GeneratorSpec& spec, const JsonValue& value, const std::string& path) const
+    {
+        spec.min = Member(value, path, "min", JsonValue::NUMBER).number;
+        const JsonValue& max = Member(value, path, "max", JsonValue::NUMBER);
+        spec.max = max.number;
+        if (spec.max < spec.min)
+        {
+            Fail(max, path + ".max", "must not be lower than min");
+        }
+    }
+
+    /**
+     * Validate the optional bounds of a law, defaulting to its whole support.
+     * \param spec The generator to set the bounds of.
+     * \param value The generator object.
+     * \param path Path of the generator in the document.
+     * \param lowest Lower end of the support of the law.
+     * \param lowestName Name of the lower end, for errors.
+     */
+    void ValidateOptionalBounds(GeneratorSpec& spec,
+                                const JsonValue& value,
+                                const std::string& path,
+                                double lowest,
+                                const std::string& lowestName) const
+    {
+        spec.min = lowest;
+        spec.max = std::numeric_limits<double>::infinity();
+        if (const JsonValue* min = value.Find("min"))
+        {
+            spec.min = Member(value, path, "min", JsonValue::NUMBER).number;
+            if (spec.min < lowest)
+            {
+                Fail(*min, path + ".min", "must not be lower than " + lowestName);
+            }
+        }
+        if (const JsonValue* max = value.Find("max"))
+        {
+            spec.max = Member(value, path, "max", JsonValue::NUMBER).number;
+            if (!(spec.max > spec.min))
+            {
+                Fail(*max, path + ".max", "must be greater than min");
+            }
+        }
+    }
+
+    void ValidateCdf(GeneratorSpec& spec, const JsonValue& cdf, const std::string& path) const
+    {
+        if (cdf.array.empty())
+        {
+            Fail(cdf, path, "must hold at least one point");
+        }
+
+        for (std::size_t i = 0; i < cdf.array.size(); i++)
+        {
+            const JsonValue& entry = cdf.array[i];
+            std::string entryPath = path + "[" + std::to_string(i) + "]";
+            CheckObject(entry, entryPath, {"value", "cumulative"});
+            const JsonValue& value = Member(entry, entryPath, "value", JsonValue::NUMBER);
+            const JsonValue& cumulative = Member(entry, entryPath, "cumulative", JsonValue::NUMBER);
+            if (cumulative.number < 0 || cumulative.number > 1)
+            {
+                Fail(cumulative, entryPath + ".cumulative", "must be between 0 and 1");
+            }
+            if (!spec.distribution.empty())
+            {
+                if (value.number < spec.distribution.back().first)
+                {
+                    Fail(value, entryPath + ".value", "must not be lower than the previous value");
+                }
+                if (cumulative.number < spec.distribution.back().second)
+                {
+                    Fail(cumulative,
+                         entryPath + ".cumulative",
+                         "must not be lower than the previous cumulative probability");
+                }
+            }
+            spec.distribution.emplace_back(value.number, cumulative.number);
+        }
+        if (std::abs(spec.distribution.back().second - 1) > 1e-9)
+        {
+            Fail(cdf.array.back(), path, "the last cumulative probability must be 1");
+        }
+    }
+
+    /**
+     * Validate the packet generators of a sub-flow or of a state: either a
+     * joint histogram, or both generators.
+     * \param object The sub-flow or the state.
+     * \param path Path of the object in the document.
+     * \return The validated generators.
+     */
+    PacketsSpec ValidatePackets(const JsonValue& object, const std::string& path) const
+    {
+        PacketsSpec spec;
+        if (const JsonValue* joint = object.Find("joint"))
+        {
+            if (object.Find("payload-size") || object.Find("inter-packet-times"))
+            {
+                Fail(*joint, path, "'joint' replaces 'payload-size' and 'inter-packet-times'");
+            }
+            spec.joint = true;
+            spec.jointHistogram =
+                ValidateJoint(Member(object, path, "joint", JsonValue::OBJECT), path + ".joint");
+        }
+        else
+        {
+            const JsonValue& payloadSize = Member(object, path, "payload-size", JsonValue::OBJECT);
+            spec.payloadSize = ValidateGenerator(payloadSize, path + ".payload-size");
+            ValidatePayloadSizeBounds(spec.payloadSize, payloadSize, path + ".payload-size");
+            const JsonValue& interPacketTimes =
+                Member(object, path, "inter-packet-times", JsonValue::OBJECT);
+            spec.interPacketTimes = ValidateGenerator(interPacketTimes, path + ".inter-packet-times");
+            ValidateTimeSupport(spec.interPacketTimes, interPacketTimes, path + ".inter-packet-times", false);
+        }
+        return spec;
+    }
+
+    /**
+     * Check that a time generator never draws a negative time, and that it
+     * does not always draw 0, which would stall the simulation at one
+     * instant. The replayed samples are not checked.
+     * \param spec The validated generator.
+     * \param value The generator object.
+     * \param path Path of the generator in the document.
+     * \param positive true if every time must be positive, as for dwell times.
+     */
+    void ValidateTimeSupport(const GeneratorSpec& spec,
+                             const JsonValue& value,
+                             const std::string& path,
+                             bool positive) const
+    {
+        auto check = [this, positive](const JsonValue& time, const std::string& timePath) {
+            if (time.number < 0 || (positive && time.number == 0))
+            {
+                Fail(time, timePath, positive ? "must be positive" : "must not be negative");
+            }
+        };
+
+        double largest = spec.max;
+        switch (spec.type)
+        {
+        case GeneratorType::UNIFORM:
+        case GeneratorType::NORMAL:
+            check(*value.Find("min"), path + ".min");
+            break;
+        case GeneratorType::DIST:
+        case GeneratorType::EMPIRICAL: {
+            // Every point is checked, whatever its probability
+            bool dist = spec.type == GeneratorType::DIST;
+            const JsonValue& points = *value.Find(dist ? "distribution" : "cdf");
+            std::string pointsPath = path + (dist ? ".distribution" : ".cdf");
+            largest = 0;
+            for (std::size_t i = 0; i < points.array.size(); i++)
+            {
+                check(*points.array[i].Find("value"), pointsPath + "[" + std::to_string(i) + "].value");
+                if (!dist || spec.distribution[i].second > 0)
+                {
+                    largest = std::max(largest, spec.distribution[i].first);
+                }
+            }
+            break;
+        }
+        default:
+            // The laws draw positive times
+            return;
+        }
+        if (!(largest > 0))
+        {
+            Fail(value, path, "always draws 0");
+        }
+    }
+
+    /**
+     * Check that every payload size a generator can draw lies in
+     * [0, 4294967295], since the samples are cast to uint32_t. The
+     * unbounded laws need a finite "max". The replayed samples are not
+     * checked.
+     * \param spec The validated generator.
+     * \param value The generator object.
+     * \param path Path of the generator in the document.
+     */
+    void ValidatePayloadSizeBounds(const GeneratorSpec& spec,
+                                   const JsonValue& value,
+                                   const std::string& path) const
+    {
+        auto check = [this](const JsonValue& size, const std::string& sizePath) {
+            if (size.number < 0 || size.number > LARGEST_PAYLOAD_SIZE)
+            {
+                Fail(size, sizePath, "must be between 0 and 4294967295 for a payload size");
+            }
+        };
+
+        switch (spec.type)
+        {
+        case GeneratorType::UNIFORM:
+        case GeneratorType::NORMAL:
+            check(*value.Find("min"), path + ".min");
+            check(*value.Find("max"), path + ".max");
+            break;
+        case GeneratorType::EXPONENTIAL:
+        case GeneratorType::PARETO:
+        case GeneratorType::WEIBULL:
+        case GeneratorType::LOGNORMAL:
+            // Their lower end is already at least 0
+            if (!value.Find("max"))
+            {
+                Fail(value, path, "a payload size needs a 'max' of at most 4294967295");
+            }
+            check(*value.Find("max"), path + ".max");
+            break;
+        case GeneratorType::DIST:
+        case GeneratorType::EMPIRICAL: {
+            bool dist = spec.type == GeneratorType::DIST;
+            const JsonValue& points = *value.Find(dist ? "distribution" : "cdf");
+            std::string pointsPath = path + (dist ? ".distribution" : ".cdf");
+            for (std::size_t i = 0; i < points.array.size(); i++)
+            {
+                check(*points.array[i].Find("value"), pointsPath + "[" + std::to_string(i) + "].value");
+            }
+            break;
+        }
+        case GeneratorType::REPLAY:
+            break;
+        }
+    }
+
+    /**
+     * Validate the states and the transition matrix of a Markov-modulated
+     * sub-flow.
+     * \param value The "markov" object.
+     * \param path Path of the object in the document.
+     * \return The states, with their row of the transition matrix.
+     */
+    std::vector<ModulationStateSpec> ValidateMarkov(const JsonValue& value,
+                                                    const std::string& path) const
+    {
+        CheckObject(value, path, {"states", "transitions"});
+        const JsonValue& states = Member(value, path, "states", JsonValue::ARRAY);
+        if (states.array.empty())
+        {
+            Fail(states, path + ".states", "must hold at least one state");
+        }
+
+        std::vector<ModulationStateSpec> specs;
+        for (std::size_t i = 0; i < states.array.size(); i++)
+        {
+            const JsonValue& state = states.array[i];
+            std::string statePath = path + ".states[" + std::to_string(i) + "]";
+            CheckObject(state,
+                        statePath,
+                        {"dwell-time"},
+                        {"payload-size", "inter-packet-times", "joint"});
+            ModulationStateSpec spec;
+            const JsonValue& dwellTime = Member(state, statePath, "dwell-time", JsonValue::OBJECT);
+            spec.dwellTime = ValidateGenerator(dwellTime, statePath + ".dwell-time");
+            ValidateTimeSupport(spec.dwellTime, dwellTime, statePath + ".dwell-time", true);
+            spec.packets = ValidatePackets(state, statePath);
+            specs.push_back(std::move(spec));
+        }
+
+        // One row per state, the next state is drawn from the row of the current one
+        const JsonValue& transitions = Member(value, path, "transitions", JsonValue::ARRAY);
+        std::vector<double> weights =
+            ValidateWeights(transitions, path + ".transitions", specs.size(), specs.size(), "state", "state");
+        for (std::size_t i = 0; i < specs.size(); i++)
+        {
+            specs[i].transitions.assign(weights.begin() + i * specs.size(),
+                                        weights.begin() + (i + 1) * specs.size());
+            if (std::accumulate(specs[i].transitions.begin(), specs[i].transitions.end(), 0.0) <= 0)
+            {
+                Fail(transitions.array[i],
+                     path + ".transitions[" + std::to_string(i) + "]",
+                     "weights must sum to a positive value");
+            }
+        }
+        return specs;
+    }
+
+    /**
+     * Validate a joint (payload size, inter-packet time) histogram.
+     * \param value The "joint" object.
+     * \param path Path of the object in the document.
+     * \return The validated histogram.
+     */
+    JointSpec ValidateJoint(const JsonValue& value, const std::string& path) const
+    {
+        CheckObject(value, path, {"payload-size-edges", "inter-packet-time-edges", "weights"});
+        JointSpec spec;
+        spec.payloadSizeEdges = ValidateEdges(value, path, "payload-size-edges");
+        if (spec.payloadSizeEdges.back() > LARGEST_PAYLOAD_SIZE)
+        {
+            const JsonValue& edges = *value.Find("payload-size-edges");
+            Fail(edges.array.back(),
+                 path + ".payload-size-edges[" + std::to_string(edges.array.size() - 1) + "]",
+                 "must be at most 4294967295");
+        }
+        spec.interPacketTimeEdges = ValidateEdges(value, path, "inter-packet-time-edges");
+
+        // One row per payload size bin, one column per inter-packet time bin
+        const JsonValue& weights = Member(value, path, "weights", JsonValue::ARRAY);
+        spec.weights = ValidateWeights(weights,
+                                       path + ".weights",
+                                       spec.payloadSizeEdges.size() - 1,
+                                       spec.interPacketTimeEdges.size() - 1,
+                                       "payload size bin",
+                                       "inter-packet time bin");
+        if (std::accumulate(spec.weights.begin(), spec.weights.end(), 0.0) <= 0)
+        {
+            Fail(weights, path + ".weights", "weights must sum to a positive value");
+        }
+
+        // Inter-packet times that are always 0 would stall the simulation
+        std::size_t columns = spec.interPacketTimeEdges.size() - 1;
+        bool positiveTime = false;
+        for (std::size_t cell = 0; cell < spec.weights.size(); cell++)
+        {
+            positiveTime |= spec.weights[cell] > 0 && spec.interPacketTimeEdges[cell % columns + 1] > 0;
+        }
+        if (!positiveTime)
+        {
+            Fail(weights, path + ".weights", "the inter-packet time is always 0");
+        }
+        return spec;
+    }
+
+    /**
+     * Validate a matrix of non-negative weights.
+     * \param matrix The array of rows.
+     * \param path Path of the matrix in the document.
+     * \param rows Expected number of rows.
+     * \param columns Expected number of weights per row.
+     * \param rowName What a row stands for, for the error messages.
+     * \param columnName What a column stands for, for the error messages.
+     * \return The weights, row by row.
+     */
+    std::vector<double> ValidateWeights(const JsonValue& matrix,
+                                        const std::string& path,
+                                        std::size_t rows,
+                                        std::size_t columns,
+                                        const std::string& rowName,
+                                        const std::string& columnName) const
+    {
+        if (matrix.array.size() != rows)
+        {
+            Fail(matrix, path, "expected " + std::to_string(rows) + " rows, one per " + rowName);
+        }
+        std::vector<double> weights;
+        for (std::size_t i = 0; i < rows; i++)
+        {
+            std::string rowPath = path + "[" + std::to_string(i) + "]";
+            const JsonValue& row = matrix.array[i];
+            if (row.type != JsonValue::ARRAY || row.array.size() != columns)
+            {
+                Fail(row,
+                     rowPath,
+                     "expected an array of " + std::to_string(columns) + " weights, one per " +
+                         columnName);
+            }
+            for (std::size_t j = 0; j < columns; j++)
+            {
+                const JsonValue& weight = row.array[j];
+                std::string weightPath = rowPath + "[" + std::to_string(j) + "]";
+                if (weight.type != JsonValue::NUMBER)
+                {
+                    Fail(weight, weightPath, std::string("expected a number, found ") + TypeName(weight.type));
+                }
+                if (weight.number < 0)
+                {
+                    Fail(weight, weightPath, "must not be negative");
+                }
+                weights.push_back(weight.number);
+            }
+        }
+        return weights;
+    }
+
+    /**
+     * Validate the bin edges of a joint histogram.
+     * \param object The joint histogram.
+     * \param path Path of the histogram in the document.
+     * \param key Name of the edges member.
+     * \return The edges: at least two, non-negative and non-decreasing.
+     */
+    std::vector<double> ValidateEdges(const JsonValue& object,
+                                      const std::string& path,
+                                      const std::string& key) const
+    {
+        const JsonValue& edges = Member(object, path, key, JsonValue::ARRAY);
+        if (edges.array.size() < 2)
+        {
+            Fail(edges, path + "." + key, "must hold at least two edges");
+        }
+
+        std::vector<double> values;
+        for (std::size_t i = 0; i < edges.array.size(); i++)
+        {
+            const JsonValue& edge = edges.array[i];
+            std::string edgePath = path + "." + key + "[" + std::to_string(i) + "]";
+            if (edge.type != JsonValue::NUMBER)
+            {
+                Fail(edge, edgePath, std::string("expected a number, found ") + TypeName(edge.type));
+            }
+            if (edge.number < 0)
+            {
+                Fail(edge, edgePath, "must not be negative");
+            }
+            if (!values.empty() && edge.number < values.back())
+            {
+                Fail(edge, edgePath, "must not be lower than the previous edge");
+            }
+            values.push_back(edge.number);
+        }
+        return values;
+    }
+
+    void ValidateDistribution(GeneratorSpec& spec, const JsonValue& distribution, const std::string& path) const
+    {
+        if (distribution.array.empty())
+        {
+            Fail(distribution, path, "must hold at least one value");
+        }
+
+        double total = 0;
+        for (std::size_t i = 0; i < distribution.array.size(); i++)
+        {
+            const JsonValue& entry = distribution.array[i];
+            std::string entryPath = path + "[" + std::to_string(i) + "]";
+            CheckObject(entry, entryPath, {"value", "probability"});
+            double value = Member(entry, entryPath, "value", JsonValue::NUMBER).number;
+            const JsonValue& probability = Member(entry, entryPath, "probability", JsonValue::NUMBER);
+            if (probability.number < 0)
+            {
+                Fail(probability, entryPath + ".probability", "must not be negative");
+            }
+            total += probability.number;
+            spec.distribution.emplace_back(value, probability.number);
+        }
+        if (total <= 0)
+        {
+            Fail(distribution, path, "probabilities must sum to a positive value");
+        }
+    }
+
+    /// Resolve a path relative to the directory of the profile.
+    std::string ResolvePath(const std::string& path) const
+    {
+        std::size_t slash = m_filename.find_last_of('/');
+        if (path[0] == '/' || slash == std::string::npos)
+        {
+            return path;
+        }
+        return m_filename.substr(0, slash + 1) + path;
+    }
+
+    const std::string& m_filename; ///< Path of the profile.
+};
+
+/// Build a generator from validated parameters.
+SubFlow::Generator
+MakeGenerator(const GeneratorSpec& spec)
+{
+    switch (spec.type)
+    {
+    case GeneratorType::UNIFORM:
+        return RandomGeneratorUniform(spec.min, spec.max);
+    case GeneratorType::NORMAL:
+        return RandomGeneratorNormal(spec.min, spec.max, spec.mean, spec.stdDev);
+    case GeneratorType::DIST:
+        return RandomGeneratorDist(spec.distribution);
+    case GeneratorType::REPLAY:
+        return RandomGeneratorReplay(spec.file);
+    case GeneratorType::EXPONENTIAL:
+        return RandomGeneratorExponential(spec.mean, spec.min, spec.max);
+    case GeneratorType::PARETO:
+        return RandomGeneratorPareto(spec.scale, spec.shape, spec.min, spec.max);
+    case GeneratorType::WEIBULL:
+        return RandomGeneratorWeibull(spec.scale, spec.shape, spec.min, spec.max);
+    case GeneratorType::LOGNORMAL:
+        return RandomGeneratorLognormal(spec.mu, spec.sigma, spec.min, spec.max);
+    case GeneratorType::EMPIRICAL:
+        return RandomGeneratorEmpirical(spec.distribution);
+    }
+    NS_FATAL_ERROR("Unknown generator type");
+}
+
+/// Build a SubFlow from validated packet generators.
+std::shared_ptr<SubFlow>
+MakeSubFlow(uint16_t id, const PacketsSpec& spec)
+{
+    if (spec.joint)
+    {
+        const JointSpec& joint = spec.jointHistogram;
+        return std::make_shared<SubFlow>(
+            id,
+            RandomGeneratorJoint(joint.payloadSizeEdges, joint.interPacketTimeEdges, joint.weights));
+    }
+    return std::make_shared<SubFlow>(id,
+                                     MakeGenerator(spec.payloadSize),
+                                     MakeGenerator(spec.interPacketTimes));
+}
+
+/// Profiles loaded so far, by path.
+std::map<std::string, TrafficProfileLoader::TrafficProfile>&
+GetCache()
+{
+    static std::map<std::string, TrafficProfileLoader::TrafficProfile> cache;
+    return cache;
+}
+
+} // namespace
+
+TrafficProfileLoader::TrafficProfile
+TrafficProfileLoader::Load(const std::string& filename)
+{
+    NS_LOG_FUNCTION(filename);
+
+    TrafficProfile& trafficProfile = GetCache()[filename];
+    if (trafficProfile.empty())
+    {
+        std::ifstream file(filename);
+        NS_ABORT_MSG_IF(!file.is_open(), "Unable to open the file " << filename);
+        std::ostringstream text;
+        text << file.rdbuf();
+
+        std::string document = text.str();
+        JsonValue root = JsonParser(document, filename).Parse();
+        ProfileSpec spec = ProfileValidator(filename).Validate(root);
+
+        // Tables are built once here and shared by every application using
+        // the profile
+        trafficProfile.reserve(spec.size());
+        for (const auto& subFlow : spec)
+        {
+            if (subFlow.states.empty())
+            {
+                trafficProfile.push_back(MakeSubFlow(subFlow.id, subFlow.packets));
+                continue;
+            }
+
+            // The generators of every state are built now, a state change
+            // only draws from them
+            std::vector<SubFlow::ModulationState> states;
+            for (const auto& state : subFlow.states)
+            {
+                std::vector<std::pair<double, double>> transitions;
+                for (std::size_t next = 0; next < state.transitions.size(); next++)
+                {
+                    transitions.emplace_back(next, state.transitions[next]);
+                }
+                states.push_back({MakeSubFlow(subFlow.id, state.packets),
+                                  MakeGenerator(state.dwellTime),
+                                  RandomGeneratorDist(transitions)});
+            }
+            trafficProfile.push_back(std::make_shared<SubFlow>(subFlow.id, std::move(states)));
+        }
+        NS_LOG_INFO("Loaded " << trafficProfile.size() << " sub-flows from " << filename);
+    }
+    return trafficProfile;
+}
+
+void
+TrafficProfileLoader::ClearCache()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    GetCache().clear();
+}
+
+} // namespace ns3
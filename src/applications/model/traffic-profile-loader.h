@@ -0,0 +1,79 @@
+#ifndef TRAFFIC_PROFILE_LOADER_H
+#define TRAFFIC_PROFILE_LOADER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sub-flow.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup applications
+ * Loads IotPassiveApp traffic profiles from JSON files.
+ *
+ * A profile is an object holding a "sub-flows" array. Each sub-flow has an
+ * integer "id" and a "payload-size" and an "inter-packet-times" generator.
+ * A generator has a "type" and the fields of that type:
+ *  - "uniform": "min", "max"
+ *  - "normal": "min", "max", "mean", "std-dev"
+ *  - "dist": "distribution", an array of {"value", "probability"} objects
+ *  - "replay": "file", a RandomGeneratorReplay sample file, relative to
+ *    the directory of the profile unless absolute
+ *  - "exponential": "mean"
+ *  - "pareto": "scale", "shape"
+ *  - "weibull": "scale", "shape"
+ *  - "lognormal": "mu", "sigma", of the logarithm of the samples
+ *  - "empirical": "cdf", an array of {"value", "cumulative"} objects, a
+ *    piecewise-linear CDF whose last cumulative probability is 1
+ *
+ * The exponential, pareto, weibull and lognormal laws take optional "min"
+ * and "max" bounds and are truncated to them. As a "payload-size", they
+ * need a "max" of at most 4294967295.
+ *
+ * A sub-flow whose payload sizes and inter-packet times are correlated
+ * replaces both generators with a "joint" histogram: "payload-size-edges"
+ * and "inter-packet-time-edges" bound the bins, and "weights" is a matrix
+ * with one row per payload size bin and one weight per inter-packet time
+ * bin. Each packet draws a cell, then a uniform pair inside it.
+ *
+ * A Markov-modulated sub-flow has a "markov" object instead of its packet
+ * generators or joint histogram. Its "states" each have a "dwell-time"
+ * generator, in seconds, and either both packet generators or a "joint"
+ * histogram; "transitions" holds one row of weights per state, from which
+ * the next state is drawn. The sub-flow starts in state 0.
+ *
+ * The schema is strict: a missing or unknown key, a wrong type or an
+ * invalid value is a fatal error naming the file and the offending
+ * element. Every payload size a generator or a joint histogram can draw
+ * must lie in [0, 4294967295]. Inter-packet times must not be negative
+ * nor always 0, and dwell times must be positive.
+ *
+ * Files are parsed once per process and cached by path: every Load of a
+ * path returns the same SubFlow objects. Their tables are never modified,
+ * and applications draw from their own generator states; only the
+ * stateless GetPayloadSize() and GetInterPacketTime() overloads advance
+ * the states held by the shared generators.
+ */
+class TrafficProfileLoader
+{
+public:
+    /// A traffic profile, as accepted by IotPassiveApp::SetTrafficProfile.
+    using TrafficProfile = std::vector<std::shared_ptr<SubFlow>>;
+
+    /**
+     * Load a traffic profile, parsing the file on first use only.
+     * \param filename Path of the JSON profile.
+     * \return The shared sub-flows of the profile.
+     */
+    static TrafficProfile Load(const std::string& filename);
+
+    /// Forget the cached profiles, so that the next Load reads the files again.
+    static void ClearCache();
+};
+
+} // namespace ns3
+
+#endif /* TRAFFIC_PROFILE_LOADER_H */
@@ -0,0 +1,634 @@
+#include <ns3/application-container.h>
+#include <ns3/boolean.h>
+#include <ns3/config.h>
+#include <ns3/inet-socket-address.h>
+#include <ns3/internet-stack-helper.h>
+#include <ns3/iot-client.h>
+#include <ns3/iot-helper.h>
+#include <ns3/iot-passive-app.h>
+#include <ns3/ipv4-address-helper.h>
+#include <ns3/node-container.h>
+#include <ns3/packet.h>
+#include <ns3/simple-net-device-helper.h>
+#include <ns3/simulator.h>
+#include <ns3/string.h>
+#include <ns3/tcp-socket-factory.h>
+#include <ns3/test.h>
+#include <ns3/udp-socket-factory.h>
+#include <ns3/uinteger.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+/// Payload size of the test profile, split into three datagrams.
+constexpr uint32_t PAYLOAD_SIZE = 2500;
+
+/// Largest datagram of the camera.
+constexpr uint32_t MAX_DATAGRAM_SIZE = 1000;
+
+/// Time between two payloads of the test profile, in seconds.
+constexpr double INTER_PACKET_TIME = 0.1;
+
+/// Payload size of the TCP test profile, many times the send buffer.
+constexpr uint32_t LARGE_PAYLOAD_SIZE = 200000;
+
+/// Send buffer of the TCP sockets of the TCP test.
+constexpr uint32_t SND_BUF_SIZE = 16384;
+
+/**
+ * Sub-flow sending payloads of a constant size at a constant interval.
+ * \param id Identifier of the sub-flow.
+ * \param payloadSize Size of the payloads, in bytes.
+ * \param interPacketTime Time between two payloads, in seconds.
+ * \return The sub-flow.
+ */
+std::shared_ptr<SubFlow>
+MakeSubFlow(uint16_t id, uint32_t payloadSize, double interPacketTime)
+{
+    return std::make_shared<SubFlow>(
+        id,
+        RandomGeneratorDist(std::vector<std::pair<double, double>>{{payloadSize, 1}}),
+        RandomGeneratorDist(std::vector<std::pair<double, double>>{{interPacketTime, 1}}));
+}
+
+/**
+ * Profile of one sub-flow sending PAYLOAD_SIZE bytes every
+ * INTER_PACKET_TIME seconds.
+ * \return The profile.
+ */
+std::vector<std::shared_ptr<SubFlow>>
+MakeProfile()
+{
+    return {MakeSubFlow(1, PAYLOAD_SIZE, INTER_PACKET_TIME)};
+}
+
+} // namespace
+
+/**
+ * \ingroup applications-test
+ * Check the UDP transport of IotPassiveApp and IotClient: the client
+ * subscribes, payloads larger than MaxDatagramSize are split into
+ * datagrams, and the traffic stops once the client unsubscribes. With a
+ * camera starting after the client, the SUBSCRIBE datagram is repeated
+ * until the traffic starts.
+ */
+class IotUdpTransportTestCase : public TestCase
+{
+public:
+    /**
+     * \param cameraStart Start time of the camera.
+     */
+    IotUdpTransportTestCase(Time cameraStart);
+
+private:
+    void DoRun() override;
+
+    /**
+     * Record a payload sent by the camera.
+     * \param packet A packet of the size of the payload.
+     */
+    void CameraTx(Ptr<const Packet> packet, const Address&, uint16_t);
+
+    /**
+     * Record a datagram sent by the camera.
+     * \param packet The datagram.
+     */
+    void CameraTxChunk(Ptr<const Packet> packet, const Address&, uint16_t);
+
+    /**
+     * Record a datagram received by the client.
+     * \param packet The datagram.
+     */
+    void ClientRx(Ptr<const Packet> packet, const Address&);
+
+    /**
+     * Record a control datagram sent by the client.
+     * \param packet The datagram.
+     */
+    void ClientTx(Ptr<const Packet> packet);
+
+    Time m_cameraStart;                  ///< Start time of the camera.
+    std::vector<uint32_t> m_payloads;    ///< Sizes of the payloads sent.
+    Time m_lastPayload;                  ///< Time of the last payload sent.
+    std::vector<uint32_t> m_datagrams;   ///< Sizes of the datagrams sent.
+    uint64_t m_receivedBytes{0};         ///< Bytes received by the client.
+    uint32_t m_receivedDatagrams{0};     ///< Datagrams received by the client.
+    Time m_firstReceived;                ///< Time of the first datagram received.
+    std::vector<uint8_t> m_controls;     ///< Control datagrams sent by the client.
+};
+
+IotUdpTransportTestCase::IotUdpTransportTestCase(Time cameraStart)
+    : TestCase(cameraStart.IsZero() ? "IotPassiveApp streams over UDP to a subscribed IotClient"
+                                    : "IotClient subscribes again until a late IotPassiveApp starts"),
+      m_cameraStart(cameraStart)
+{
+}
+
+void
+IotUdpTransportTestCase::CameraTx(Ptr<const Packet> packet, const Address&, uint16_t)
+{
+    m_payloads.push_back(packet->GetSize());
+    m_lastPayload = Simulator::Now();
+}
+
+void
+IotUdpTransportTestCase::CameraTxChunk(Ptr<const Packet> packet, const Address&, uint16_t)
+{
+    m_datagrams.push_back(packet->GetSize());
+}
+
+void
+IotUdpTransportTestCase::ClientRx(Ptr<const Packet> packet, const Address&)
+{
+    if (m_receivedDatagrams == 0)
+    {
+        m_firstReceived = Simulator::Now();
+    }
+    m_receivedDatagrams++;
+    m_receivedBytes += packet->GetSize();
+}
+
+void
+IotUdpTransportTestCase::ClientTx(Ptr<const Packet> packet)
+{
+    uint8_t control;
+    packet->CopyData(&control, 1);
+    m_controls.push_back(control);
+}
+
+void
+IotUdpTransportTestCase::DoRun()
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+    SimpleNetDeviceHelper link;
+    link.SetChannelAttribute("Delay", TimeValue(MilliSeconds(1)));
+    link.SetDeviceAttribute("DataRate", StringValue("100Mbps"));
+    NetDeviceContainer devices = link.Install(nodes);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    Ipv4AddressHelper address;
+    address.SetBase("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer interfaces = address.Assign(devices);
+
+    uint16_t port = 8800;
+    IotPassiveAppHelper cameraHelper(Address(Ipv4Address::GetAny()), port);
+    cameraHelper.SetTrafficProfile(MakeProfile());
+    cameraHelper.SetAttribute("Protocol", TypeIdValue(UdpSocketFactory::GetTypeId()));
+    cameraHelper.SetAttribute("MaxDatagramSize", UintegerValue(MAX_DATAGRAM_SIZE));
+    ApplicationContainer cameraApps = cameraHelper.Install(nodes.Get(0));
+    cameraApps.Start(m_cameraStart);
+    cameraApps.Stop(Seconds(6));
+    cameraApps.Get(0)->TraceConnectWithoutContext(
+        "Tx",
+        MakeCallback(&IotUdpTransportTestCase::CameraTx, this));
+    cameraApps.Get(0)->TraceConnectWithoutContext(
+        "TxChunk",
+        MakeCallback(&IotUdpTransportTestCase::CameraTxChunk, this));
+
+    // The client leaves at 5.05 s, between two payloads
+    IotClientHelper clientHelper(Address(interfaces.GetAddress(0)), port);
+    clientHelper.SetAttribute("Protocol", TypeIdValue(UdpSocketFactory::GetTypeId()));
+    clientHelper.SetAttribute("SubscribeInterval", TimeValue(MilliSeconds(500)));
+    ApplicationContainer clientApps = clientHelper.Install(nodes.Get(1));
+    clientApps.Start(Seconds(1));
+    clientApps.Stop(Seconds(5.05));
+    clientApps.Get(0)->TraceConnectWithoutContext(
+        "Rx",
+        MakeCallback(&IotUdpTransportTestCase::ClientRx, this));
+    clientApps.Get(0)->TraceConnectWithoutContext(
+        "Tx",
+        MakeCallback(&IotUdpTransportTestCase::ClientTx, this));
+
+    Simulator::Stop(Seconds(7));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    // One SUBSCRIBE when the camera runs from the start. With a camera
+    // starting at 2.8 s, the SUBSCRIBE datagrams of 1, 1.5, 2 and 2.5 s are
+    // lost, the one of 3 s is answered and stops the next ones
+    std::size_t subscribes = m_cameraStart.IsZero() ? 1 : 5;
+    NS_TEST_ASSERT_MSG_EQ(m_controls.size(), subscribes + 1, "Unexpected control datagrams");
+    for (std::size_t i = 0; i < subscribes; ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(static_cast<uint32_t>(m_controls[i]),
+                              static_cast<uint32_t>(IotUdpControl::SUBSCRIBE),
+                              "Datagram " << i << " is not a SUBSCRIBE");
+    }
+    NS_TEST_ASSERT_MSG_EQ(static_cast<uint32_t>(m_controls.back()),
+                          static_cast<uint32_t>(IotUdpControl::UNSUBSCRIBE),
+                          "The last datagram is not an UNSUBSCRIBE");
+
+    // A payload every 100 ms from the subscription to the unsubscription
+    Time subscribed = m_cameraStart.IsZero() ? Seconds(1) : Seconds(3);
+    NS_TEST_ASSERT_MSG_GT(m_receivedDatagrams, 0, "No traffic received");
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(m_firstReceived, subscribed, "Traffic before the subscription");
+    NS_TEST_ASSERT_MSG_LT(m_firstReceived,
+                          subscribed + MilliSeconds(200),
+                          "Traffic late after the subscription");
+    std::size_t expected = std::lround((Seconds(5) - subscribed).GetSeconds() / INTER_PACKET_TIME);
+    NS_TEST_ASSERT_MSG_EQ(m_payloads.size(), expected, "Unexpected number of payloads");
+    NS_TEST_ASSERT_MSG_LT(m_lastPayload, Seconds(5.05), "Payload sent after the unsubscription");
+
+    // Tx reports whole payloads, TxChunk their datagrams
+    for (uint32_t size : m_payloads)
+    {
+        NS_TEST_ASSERT_MSG_EQ(size, PAYLOAD_SIZE, "Tx does not report the whole payload");
+    }
+    NS_TEST_ASSERT_MSG_EQ(m_datagrams.size(), 3 * m_payloads.size(), "Unexpected number of datagrams");
+    for (std::size_t i = 0; i < m_datagrams.size(); ++i)
+    {
+        uint32_t size = (i % 3 == 2) ? PAYLOAD_SIZE - 2 * MAX_DATAGRAM_SIZE : MAX_DATAGRAM_SIZE;
+        NS_TEST_ASSERT_MSG_EQ(m_datagrams[i], size, "Unexpected datagram size");
+    }
+    NS_TEST_ASSERT_MSG_EQ(m_receivedDatagrams, m_datagrams.size(), "Datagrams lost");
+    NS_TEST_ASSERT_MSG_EQ(m_receivedBytes,
+                          static_cast<uint64_t>(PAYLOAD_SIZE) * m_payloads.size(),
+                          "Bytes lost");
+}
+
+/**
+ * \ingroup applications-test
+ * Check the send queue of IotPassiveApp over TCP: a payload much larger
+ * than the socket send buffer is written in several chunks as the buffer
+ * frees, Tx reports it once, and the backlog returns to 0. A payload which
+ * would take the backlog beyond MaxSendBacklog is dropped.
+ */
+class IotTcpSendQueueTestCase : public TestCase
+{
+public:
+    IotTcpSendQueueTestCase();
+
+private:
+    void DoRun() override;
+    void DoTeardown() override;
+
+    /**
+     * Record a payload sent by the camera.
+     * \param packet A packet of the size of the payload.
+     * \param subFlowId Identifier of the SubFlow of the payload.
+     */
+    void CameraTx(Ptr<const Packet> packet, const Address&, uint16_t subFlowId);
+
+    /**
+     * Record a chunk written by the camera.
+     * \param packet The chunk.
+     */
+    void CameraTxChunk(Ptr<const Packet> packet, const Address&, uint16_t);
+
+    /**
+     * Record a change of the send queue of the camera.
+     * \param depth Number of payloads waiting.
+     * \param backlog Number of bytes waiting.
+     */
+    void CameraSendQueue(const Address&, uint32_t depth, uint64_t backlog);
+
+    /**
+     * Record a payload dropped by the camera.
+     * \param size Size of the payload.
+     * \param subFlowId Identifier of the SubFlow of the payload.
+     */
+    void CameraDrop(const Address&, uint32_t size, uint16_t subFlowId);
+
+    /**
+     * Record bytes received by the client.
+     * \param packet The bytes.
+     */
+    void ClientRx(Ptr<const Packet> packet, const Address&);
+
+    std::vector<uint32_t> m_payloads;      ///< Sizes of the payloads sent.
+    std::vector<uint16_t> m_payloadFlows;  ///< SubFlow ids of the payloads sent.
+    std::vector<uint32_t> m_chunks;        ///< Sizes of the chunks written.
+    std::vector<uint32_t> m_depths;        ///< Depths reported by SendQueue.
+    std::vector<uint64_t> m_backlogs;      ///< Backlogs reported by SendQueue.
+    std::vector<uint32_t> m_drops;         ///< Sizes of the payloads dropped.
+    std::vector<uint16_t> m_dropFlows;     ///< SubFlow ids of the payloads dropped.
+    uint64_t m_receivedBytes{0};           ///< Bytes received by the client.
+};
+
+IotTcpSendQueueTestCase::IotTcpSendQueueTestCase()
+    : TestCase("IotPassiveApp writes large TCP payloads by chunks and drops beyond its backlog")
+{
+}
+
+void
+IotTcpSendQueueTestCase::CameraTx(Ptr<const Packet> packet, const Address&, uint16_t subFlowId)
+{
+    m_payloads.push_back(packet->GetSize());
+    m_payloadFlows.push_back(subFlowId);
+}
+
+void
+IotTcpSendQueueTestCase::CameraTxChunk(Ptr<const Packet> packet, const Address&, uint16_t)
+{
+    m_chunks.push_back(packet->GetSize());
+}
+
+void
+IotTcpSendQueueTestCase::CameraSendQueue(const Address&, uint32_t depth, uint64_t backlog)
+{
+    m_depths.push_back(depth);
+    m_backlogs.push_back(backlog);
+}
+
+void
+IotTcpSendQueueTestCase::CameraDrop(const Address&, uint32_t size, uint16_t subFlowId)
+{
+    m_drops.push_back(size);
+    m_dropFlows.push_back(subFlowId);
+}
+
+void
+IotTcpSendQueueTestCase::ClientRx(Ptr<const Packet> packet, const Address&)
+{
+    m_receivedBytes += packet->GetSize();
+}
+
+void
+IotTcpSendQueueTestCase::DoRun()
+{
+    // A send buffer much smaller than a payload, for the camera and the client
+    Config::SetDefault("ns3::TcpSocket::SndBufSize", UintegerValue(SND_BUF_SIZE));
+
+    NodeContainer nodes;
+    nodes.Create(2);
+    SimpleNetDeviceHelper link;
+    link.SetChannelAttribute("Delay", TimeValue(MilliSeconds(1)));
+    link.SetDeviceAttribute("DataRate", StringValue("100Mbps"));
+    NetDeviceContainer devices = link.Install(nodes);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    Ipv4AddressHelper address;
+    address.SetBase("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer interfaces = address.Assign(devices);
+
+    // Two sub-flows whose payloads are due together, 2 s after the
+    // connection: the second finds the first still queued and does not fit
+    uint16_t port = 8800;
+    IotPassiveAppHelper cameraHelper(Address(Ipv4Address::GetAny()), port);
+    cameraHelper.SetTrafficProfile(std::vector<std::shared_ptr<SubFlow>>{
+        MakeSubFlow(1, LARGE_PAYLOAD_SIZE, 2),
+        MakeSubFlow(2, LARGE_PAYLOAD_SIZE, 2)});
+    cameraHelper.SetAttribute("Protocol", TypeIdValue(TcpSocketFactory::GetTypeId()));
+    cameraHelper.SetAttribute("MaxSendBacklog", UintegerValue(3 * LARGE_PAYLOAD_SIZE / 2));
+    ApplicationContainer cameraApps = cameraHelper.Install(nodes.Get(0));
+    cameraApps.Start(Seconds(0));
+    cameraApps.Stop(Seconds(4.5));
+    Ptr<Application> camera = cameraApps.Get(0);
+    camera->TraceConnectWithoutContext("Tx",
+                                       MakeCallback(&IotTcpSendQueueTestCase::CameraTx, this));
+    camera->TraceConnectWithoutContext(
+        "TxChunk",
+        MakeCallback(&IotTcpSendQueueTestCase::CameraTxChunk, this));
+    camera->TraceConnectWithoutContext(
+        "SendQueue",
+        MakeCallback(&IotTcpSendQueueTestCase::CameraSendQueue, this));
+    camera->TraceConnectWithoutContext("Drop",
+                                       MakeCallback(&IotTcpSendQueueTestCase::CameraDrop, this));
+
+    IotClientHelper clientHelper(Address(interfaces.GetAddress(0)), port);
+    clientHelper.SetAttribute("Protocol", TypeIdValue(TcpSocketFactory::GetTypeId()));
+    ApplicationContainer clientApps = clientHelper.Install(nodes.Get(1));
+    clientApps.Start(Seconds(1));
+    clientApps.Stop(Seconds(5));
+    clientApps.Get(0)->TraceConnectWithoutContext(
+        "Rx",
+        MakeCallback(&IotTcpSendQueueTestCase::ClientRx, this));
+
+    Simulator::Stop(Seconds(6));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    // The first payload is sent whole, the second one dropped
+    NS_TEST_ASSERT_MSG_EQ(m_payloads.size(), 1U, "Unexpected number of payloads");
+    NS_TEST_ASSERT_MSG_EQ(m_payloads[0],
+                          LARGE_PAYLOAD_SIZE,
+                          "Tx does not report the whole payload");
+    NS_TEST_ASSERT_MSG_EQ(m_payloadFlows[0], 1, "Wrong SubFlow sent");
+    NS_TEST_ASSERT_MSG_EQ(m_drops.size(), 1U, "Unexpected number of drops");
+    NS_TEST_ASSERT_MSG_EQ(m_drops[0], LARGE_PAYLOAD_SIZE, "Wrong size dropped");
+    NS_TEST_ASSERT_MSG_EQ(m_dropFlows[0], 2, "Wrong SubFlow dropped");
+
+    // Written by chunks no larger than the send buffer
+    NS_TEST_ASSERT_MSG_GT(m_chunks.size(), 1U, "Payload written in a single chunk");
+    for (uint32_t chunk : m_chunks)
+    {
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(chunk, SND_BUF_SIZE, "Chunk larger than the send buffer");
+    }
+    NS_TEST_ASSERT_MSG_EQ(std::accumulate(m_chunks.begin(), m_chunks.end(), uint64_t{0}),
+                          LARGE_PAYLOAD_SIZE,
+                          "Chunks do not add up to the payload");
+    NS_TEST_ASSERT_MSG_EQ(m_receivedBytes, LARGE_PAYLOAD_SIZE, "Bytes lost");
+
+    // The backlog grows beyond the send buffer, then drains back to 0
+    NS_TEST_ASSERT_MSG_GT(m_backlogs.size(), 1U, "Send queue changes not reported");
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(*std::max_element(m_backlogs.begin(), m_backlogs.end()),
+                                LARGE_PAYLOAD_SIZE - SND_BUF_SIZE,
+                                "Payload not queued");
+    NS_TEST_ASSERT_MSG_EQ(m_backlogs.back(), 0U, "Backlog not drained");
+    NS_TEST_ASSERT_MSG_EQ(m_depths.back(), 0U, "Send queue not emptied");
+    for (std::size_t i = 1; i < m_backlogs.size(); ++i)
+    {
+        bool changed = m_backlogs[i] != m_backlogs[i - 1] || m_depths[i] != m_depths[i - 1];
+        NS_TEST_ASSERT_MSG_EQ(changed,
+                              true,
+                              "Send queue reported without a change");
+    }
+}
+
+void
+IotTcpSendQueueTestCase::DoTeardown()
+{
+    // The send buffer size is a global default
+    Config::Reset();
+}
+
+/**
+ * \ingroup applications-test
+ * Check that MultiplexSends only changes how the sends are scheduled. A
+ * first client subscribes then leaves while the camera has sends of its
+ * slot queued, and a second client takes the freed slot before they are
+ * due. With and without multiplexing, each client receives the same
+ * packets at the same times, and the sends queued for the first client
+ * never fire once it has left.
+ */
+class IotMultiplexSlotReuseTestCase : public TestCase
+{
+public:
+    IotMultiplexSlotReuseTestCase();
+
+private:
+    void DoRun() override;
+
+    /// Payload sent by the camera.
+    struct SentPayload
+    {
+        Time time;          ///< Time of the send.
+        Ipv4Address client; ///< Address of the client.
+        uint16_t subFlowId; ///< Identifier of the SubFlow.
+    };
+
+    /**
+     * Run the scenario.
+     * \param multiplex Value of the MultiplexSends attribute of the camera.
+     * \return The payloads sent by the camera.
+     */
+    std::vector<SentPayload> RunScenario(bool multiplex);
+
+    /**
+     * Record a payload sent by the camera.
+     * \param address Address of the client.
+     * \param subFlowId Identifier of the SubFlow of the payload.
+     */
+    void CameraTx(Ptr<const Packet>, const Address& address, uint16_t subFlowId);
+
+    std::vector<SentPayload> m_sent; ///< Payloads sent in the current run.
+};
+
+IotMultiplexSlotReuseTestCase::IotMultiplexSlotReuseTestCase()
+    : TestCase("IotPassiveApp sends the same packets with MultiplexSends when slots are reused")
+{
+}
+
+void
+IotMultiplexSlotReuseTestCase::CameraTx(Ptr<const Packet>,
+                                        const Address& address,
+                                        uint16_t subFlowId)
+{
+    Ipv4Address client = InetSocketAddress::ConvertFrom(address).GetIpv4();
+    m_sent.push_back({Simulator::Now(), client, subFlowId});
+}
+
+std::vector<IotMultiplexSlotReuseTestCase::SentPayload>
+IotMultiplexSlotReuseTestCase::RunScenario(bool multiplex)
+{
+    m_sent.clear();
+
+    NodeContainer nodes;
+    nodes.Create(3);
+    SimpleNetDeviceHelper link;
+    link.SetChannelAttribute("Delay", TimeValue(MilliSeconds(1)));
+    link.SetDeviceAttribute("DataRate", StringValue("100Mbps"));
+    NetDeviceContainer devices = link.Install(nodes);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    Ipv4AddressHelper address;
+    address.SetBase("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer interfaces = address.Assign(devices);
+
+    // A fast sub-flow, and a slow one whose first send of the first client
+    // is still queued when the second client takes the slot
+    uint16_t port = 8800;
+    IotPassiveAppHelper cameraHelper(Address(Ipv4Address::GetAny()), port);
+    cameraHelper.SetTrafficProfile(std::vector<std::shared_ptr<SubFlow>>{
+        MakeSubFlow(1, PAYLOAD_SIZE, INTER_PACKET_TIME),
+        MakeSubFlow(2, PAYLOAD_SIZE, 1.55)});
+    cameraHelper.SetAttribute("Protocol", TypeIdValue(UdpSocketFactory::GetTypeId()));
+    cameraHelper.SetAttribute("MultiplexSends", BooleanValue(multiplex));
+    ApplicationContainer cameraApps = cameraHelper.Install(nodes.Get(0));
+    cameraApps.Start(Seconds(0));
+    cameraApps.Stop(Seconds(6));
+    cameraApps.Get(0)->TraceConnectWithoutContext(
+        "Tx",
+        MakeCallback(&IotMultiplexSlotReuseTestCase::CameraTx, this));
+
+    // The first client leaves at 2.05 s, the second one subscribes at 2.2 s
+    IotClientHelper clientHelper(Address(interfaces.GetAddress(0)), port);
+    clientHelper.SetAttribute("Protocol", TypeIdValue(UdpSocketFactory::GetTypeId()));
+    ApplicationContainer first = clientHelper.Install(nodes.Get(1));
+    first.Start(Seconds(1));
+    first.Stop(Seconds(2.05));
+    ApplicationContainer second = clientHelper.Install(nodes.Get(2));
+    second.Start(Seconds(2.2));
+    second.Stop(Seconds(4.05));
+
+    Simulator::Stop(Seconds(7));
+    Simulator::Run();
+    Simulator::Destroy();
+    return m_sent;
+}
+
+void
+IotMultiplexSlotReuseTestCase::DoRun()
+{
+    std::vector<SentPayload> separate = RunScenario(false);
+    std::vector<SentPayload> multiplexed = RunScenario(true);
+
+    // Same packets at the same times, in the same order
+    NS_TEST_ASSERT_MSG_EQ(multiplexed.size(), separate.size(), "Different number of payloads");
+    for (std::size_t i = 0; i < separate.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(multiplexed[i].time, separate[i].time, "Payload " << i << " moved");
+        NS_TEST_ASSERT_MSG_EQ(multiplexed[i].client,
+                              separate[i].client,
+                              "Payload " << i << " sent to another client");
+        NS_TEST_ASSERT_MSG_EQ(multiplexed[i].subFlowId,
+                              separate[i].subFlowId,
+                              "Payload " << i << " of another SubFlow");
+    }
+
+    // First client from about 1 s to 2.05 s: ten payloads of the fast
+    // sub-flow, none of the slow one. Second client from about 2.2 s to
+    // 4.05 s: eighteen of the fast sub-flow, one of the slow one, 1.55 s
+    // after it subscribed
+    Ipv4Address firstClient("10.1.1.2");
+    Ipv4Address secondClient("10.1.1.3");
+    for (const auto& sent : {separate, multiplexed})
+    {
+        uint32_t counts[2][2] = {{0, 0}, {0, 0}};
+        for (const SentPayload& payload : sent)
+        {
+            bool second = payload.client == secondClient;
+            NS_TEST_ASSERT_MSG_EQ((second || payload.client == firstClient),
+                                  true,
+                                  "Payload sent to an unknown client");
+            counts[second][payload.subFlowId - 1]++;
+            if (!second)
+            {
+                NS_TEST_ASSERT_MSG_LT(payload.time,
+                                      Seconds(2.05),
+                                      "Payload sent to the first client after it left");
+            }
+            else if (payload.subFlowId == 2)
+            {
+                NS_TEST_ASSERT_MSG_GT(payload.time,
+                                      Seconds(2.2 + 1.55),
+                                      "Send queued for the first client fired in its slot");
+            }
+        }
+        NS_TEST_ASSERT_MSG_EQ(counts[0][0], 10U, "Unexpected fast payloads to the first client");
+        NS_TEST_ASSERT_MSG_EQ(counts[0][1], 0U, "Unexpected slow payloads to the first client");
+        NS_TEST_ASSERT_MSG_EQ(counts[1][0], 18U, "Unexpected fast payloads to the second client");
+        NS_TEST_ASSERT_MSG_EQ(counts[1][1], 1U, "Unexpected slow payloads to the second client");
+    }
+}
+
+/**
+ * \ingroup applications-test
+ * Tests of IotPassiveApp and IotClient.
+ */
+class IotPassiveAppTestSuite : public TestSuite
+{
+public:
+    IotPassiveAppTestSuite();
+};
+
+IotPassiveAppTestSuite::IotPassiveAppTestSuite()
+    : TestSuite("applications-iot-passive-app", Type::UNIT)
+{
+    AddTestCase(new IotUdpTransportTestCase(Seconds(0)), TestCase::Duration::QUICK);
+    AddTestCase(new IotUdpTransportTestCase(Seconds(2.8)), TestCase::Duration::QUICK);
+    AddTestCase(new IotTcpSendQueueTestCase(), TestCase::Duration::QUICK);
+    AddTestCase(new IotMultiplexSlotReuseTestCase(), TestCase::Duration::QUICK);
+}
+
+/// Static variable for test initialization
+static IotPassiveAppTestSuite g_iotPassiveAppTestSuite;
@@ -0,0 +1,230 @@
+#include <ns3/inet-socket-address.h>
+#include <ns3/iot-stats-collector.h>
+#include <ns3/packet.h>
+#include <ns3/simulator.h>
+#include <ns3/test.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace ns3;
+
+/**
+ * \ingroup applications-test
+ * Check the mean, variance and range of RunningStats, including on values
+ * with a large offset, where the naive sum of squares loses the variance.
+ */
+class IotRunningStatsTestCase : public TestCase
+{
+public:
+    IotRunningStatsTestCase();
+
+private:
+    void DoRun() override;
+};
+
+IotRunningStatsTestCase::IotRunningStatsTestCase()
+    : TestCase("Check the Welford mean and variance of RunningStats")
+{
+}
+
+void
+IotRunningStatsTestCase::DoRun()
+{
+    IotStatsCollector::RunningStats empty;
+    NS_TEST_ASSERT_MSG_EQ(empty.GetCount(), 0U, "Values in empty statistics");
+    NS_TEST_ASSERT_MSG_EQ(empty.GetVariance(), 0, "Variance of empty statistics");
+
+    IotStatsCollector::RunningStats stats;
+    for (double value : {2, 4, 4, 4, 5, 5, 7, 9})
+    {
+        stats.Add(value);
+    }
+    NS_TEST_ASSERT_MSG_EQ(stats.GetCount(), 8U, "Wrong count");
+    NS_TEST_ASSERT_MSG_EQ_TOL(stats.GetMean(), 5, 1e-12, "Wrong mean");
+    NS_TEST_ASSERT_MSG_EQ_TOL(stats.GetVariance(), 32.0 / 7, 1e-12, "Wrong variance");
+    NS_TEST_ASSERT_MSG_EQ(stats.GetMin(), 2, "Wrong min");
+    NS_TEST_ASSERT_MSG_EQ(stats.GetMax(), 9, "Wrong max");
+
+    IotStatsCollector::RunningStats offset;
+    for (double value : {4, 7, 13, 16})
+    {
+        offset.Add(1e9 + value);
+    }
+    NS_TEST_ASSERT_MSG_EQ_TOL(offset.GetMean(), 1e9 + 10, 1e-6, "Wrong mean with an offset");
+    NS_TEST_ASSERT_MSG_EQ_TOL(offset.GetVariance(), 30, 1e-6, "Wrong variance with an offset");
+}
+
+/**
+ * \ingroup applications-test
+ * Check the buckets of LogHistogram and their JSON output.
+ */
+class IotLogHistogramTestCase : public TestCase
+{
+public:
+    IotLogHistogramTestCase();
+
+private:
+    void DoRun() override;
+};
+
+IotLogHistogramTestCase::IotLogHistogramTestCase()
+    : TestCase("Check the buckets of LogHistogram")
+{
+}
+
+void
+IotLogHistogramTestCase::DoRun()
+{
+    IotStatsCollector::LogHistogram histogram;
+    // 1 and 1.1 share the first bucket above 1, 1.2 is past 2^(1/4), 4 starts
+    // the bucket of 2^2 and the values <= 0 have their own bucket
+    for (double value : {1.0, 1.1, 1.2, 4.0, 0.0, -3.0})
+    {
+        histogram.Add(value);
+    }
+    std::ostringstream os;
+    histogram.Print(os);
+    NS_TEST_ASSERT_MSG_EQ(os.str(), "[[0,2],[1,2],[1.18921,1],[4,1]]", "Wrong buckets");
+
+    std::ostringstream emptyOs;
+    IotStatsCollector::LogHistogram().Print(emptyOs);
+    NS_TEST_ASSERT_MSG_EQ(emptyOs.str(), "[]", "Buckets in an empty histogram");
+}
+
+/**
+ * \ingroup applications-test
+ * Feed known Tx and Rx sequences to an IotStatsCollector, then check the
+ * flow statistics, the per-peer intervals, the throughput bins and the
+ * JSON summary.
+ */
+class IotStatsCollectorFlowTestCase : public TestCase
+{
+public:
+    IotStatsCollectorFlowTestCase();
+
+private:
+    void DoRun() override;
+};
+
+IotStatsCollectorFlowTestCase::IotStatsCollectorFlowTestCase()
+    : TestCase("Check the flow statistics and the summary of IotStatsCollector")
+{
+}
+
+void
+IotStatsCollectorFlowTestCase::DoRun()
+{
+    Ptr<IotStatsCollector> collector = CreateObject<IotStatsCollector>();
+    collector->SetAttribute("ThroughputInterval", TimeValue(Seconds(1)));
+
+    Address clientA = InetSocketAddress(Ipv4Address("10.0.0.2"), 49153);
+    Address clientB = InetSocketAddress(Ipv4Address("10.0.0.3"), 49153);
+    Address camera = InetSocketAddress(Ipv4Address("10.0.0.1"), 8800);
+
+    // Node 1 sends sub-flow 2 to two clients, whose packets interleave
+    auto tx = [collector](double at, const Address& peer, uint32_t size) {
+        Simulator::Schedule(Seconds(at), [collector, peer, size]() {
+            collector->CollectTx(1, Create<Packet>(size), peer, 2);
+        });
+    };
+    tx(0.5, clientA, 100);
+    tx(0.6, clientB, 1000);
+    tx(1.0, clientA, 200);
+    tx(1.6, clientB, 1000);
+    tx(2.5, clientA, 300);
+
+    // Node 2 receives from the camera
+    for (double at : {3.0, 3.25})
+    {
+        Simulator::Schedule(Seconds(at), [collector, camera]() {
+            collector->CollectRx(2, Create<Packet>(50), camera);
+        });
+    }
+
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_ASSERT_MSG_EQ((collector->GetFlowStats(1, true, 0) == nullptr), true, "Unexpected flow");
+    NS_TEST_ASSERT_MSG_EQ((collector->GetFlowStats(1, false, 2) == nullptr), true, "Unexpected flow");
+
+    const IotStatsCollector::FlowStats* sent = collector->GetFlowStats(1, true, 2);
+    NS_TEST_ASSERT_MSG_EQ((sent != nullptr), true, "Missing Tx flow");
+    NS_TEST_ASSERT_MSG_EQ(sent->sizes.GetCount(), 5U, "Wrong packet count");
+    NS_TEST_ASSERT_MSG_EQ(sent->bytes, 2600U, "Wrong byte count");
+    NS_TEST_ASSERT_MSG_EQ_TOL(sent->sizes.GetMean(), 520, 1e-9, "Wrong mean size");
+    NS_TEST_ASSERT_MSG_EQ(sent->firstPacket, Seconds(0.5), "Wrong first packet");
+    NS_TEST_ASSERT_MSG_EQ(sent->lastPacket, Seconds(2.5), "Wrong last packet");
+
+    // Intervals of each client: 0.5 s and 1.5 s for A, 1 s for B. Mixing
+    // the clients would give 0.1, 0.4, 0.6 and 0.9 s
+    NS_TEST_ASSERT_MSG_EQ(sent->intervals.GetCount(), 3U, "Wrong interval count");
+    NS_TEST_ASSERT_MSG_EQ_TOL(sent->intervals.GetMean(), 1, 1e-12, "Wrong mean interval");
+    NS_TEST_ASSERT_MSG_EQ_TOL(sent->intervals.GetVariance(), 0.25, 1e-12, "Wrong interval variance");
+    NS_TEST_ASSERT_MSG_EQ(sent->intervals.GetMin(), 0.5, "Wrong shortest interval");
+    NS_TEST_ASSERT_MSG_EQ(sent->intervals.GetMax(), 1.5, "Wrong longest interval");
+
+    NS_TEST_ASSERT_MSG_EQ(sent->throughput.size(), 3U, "Wrong number of throughput bins");
+    NS_TEST_ASSERT_MSG_EQ(sent->throughput[0], 1100U, "Wrong throughput in [0, 1) s");
+    NS_TEST_ASSERT_MSG_EQ(sent->throughput[1], 1200U, "Wrong throughput in [1, 2) s");
+    NS_TEST_ASSERT_MSG_EQ(sent->throughput[2], 300U, "Wrong throughput in [2, 3) s");
+
+    const IotStatsCollector::FlowStats* received = collector->GetFlowStats(2, false, 0);
+    NS_TEST_ASSERT_MSG_EQ((received != nullptr), true, "Missing Rx flow");
+    NS_TEST_ASSERT_MSG_EQ(received->sizes.GetCount(), 2U, "Wrong received count");
+    NS_TEST_ASSERT_MSG_EQ(received->intervals.GetMean(), 0.25, "Wrong received interval");
+    NS_TEST_ASSERT_MSG_EQ(received->throughput.size(), 4U, "Wrong number of throughput bins");
+    NS_TEST_ASSERT_MSG_EQ(received->throughput[0], 0U, "Traffic before the first packet");
+    NS_TEST_ASSERT_MSG_EQ(received->throughput[3], 100U, "Wrong received throughput");
+
+    std::string filename = CreateTempDirFilename("iot-stats.json");
+    collector->WriteSummary(filename);
+    std::ifstream in(filename);
+    std::stringstream summary;
+    summary << in.rdbuf();
+    std::string json = summary.str();
+
+    NS_TEST_ASSERT_MSG_EQ(json.rfind("{\"throughputInterval\":1,\"flows\":[", 0),
+                          0U,
+                          "Wrong summary header");
+    std::size_t txFlow = json.find("{\"node\":1,\"direction\":\"Tx\",\"subFlow\":2,\"packets\":5,"
+                                   "\"bytes\":2600,\"first\":0.5,\"last\":2.5,\"size\":{\"count\":5,");
+    std::size_t rxFlow = json.find("{\"node\":2,\"direction\":\"Rx\",\"subFlow\":0,\"packets\":2,"
+                                   "\"bytes\":100,\"first\":3,\"last\":3.25,");
+    NS_TEST_ASSERT_MSG_NE(txFlow, std::string::npos, "Missing Tx flow in " << json);
+    NS_TEST_ASSERT_MSG_NE(rxFlow, std::string::npos, "Missing Rx flow in " << json);
+    NS_TEST_ASSERT_MSG_LT(txFlow, rxFlow, "Flows not ordered by node");
+    NS_TEST_ASSERT_MSG_NE(json.find("\"interval\":{\"count\":3,\"mean\":1,\"variance\":0.25,"
+                                    "\"min\":0.5,\"max\":1.5,"),
+                          std::string::npos,
+                          "Wrong Tx intervals in " << json);
+    NS_TEST_ASSERT_MSG_NE(json.find("\"throughput\":[1100,1200,300]}"),
+                          std::string::npos,
+                          "Wrong Tx throughput in " << json);
+    NS_TEST_ASSERT_MSG_NE(json.find("\"throughput\":[0,0,0,100]}"),
+                          std::string::npos,
+                          "Wrong Rx throughput in " << json);
+    NS_TEST_ASSERT_MSG_EQ(json.substr(json.size() - 4), "\n]}\n", "Wrong summary end");
+}
+
+/**
+ * \ingroup applications-test
+ * Tests of IotStatsCollector.
+ */
+class IotStatsCollectorTestSuite : public TestSuite
+{
+public:
+    IotStatsCollectorTestSuite();
+};
+
+IotStatsCollectorTestSuite::IotStatsCollectorTestSuite()
+    : TestSuite("applications-iot-stats-collector", Type::UNIT)
+{
+    AddTestCase(new IotRunningStatsTestCase(), TestCase::Duration::QUICK);
+    AddTestCase(new IotLogHistogramTestCase(), TestCase::Duration::QUICK);
+    AddTestCase(new IotStatsCollectorFlowTestCase(), TestCase::Duration::QUICK);
+}
+
+/// Static variable for test initialization
+static IotStatsCollectorTestSuite g_iotStatsCollectorTestSuite;
@@ -0,0 +1,1080 @@
+#include <ns3/random-generator.h>
+#include <ns3/rng-seed-manager.h>
+#include <ns3/sub-flow.h>
+#include <ns3/test.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+/// Cumulative distribution function of a reference law.
+using Cdf = std::function<double(double)>;
+
+/// Number of samples drawn by each test case.
+constexpr std::size_t SAMPLE_COUNT = 100000;
+
+/// Batch size of the batch draws, chosen so that the last batch is partial.
+constexpr std::size_t BATCH_SIZE = 1000 + 37;
+
+/**
+ * Draw samples from a generator, one at a time or by batches.
+ * \param generator The generator.
+ * \param batch true to draw with Fill, false to draw with GetRandom.
+ * \param stream Stream of the state to draw from.
+ * \return SAMPLE_COUNT samples.
+ */
+std::vector<double>
+Draw(const RandomGenerator& generator, bool batch, uint64_t stream)
+{
+    // Fixed seed, so that the outcome of the tests is deterministic
+    RngSeedManager::SetSeed(1);
+    RngSeedManager::SetRun(1);
+    RandomGeneratorState state;
+    state.Seed(stream);
+
+    std::vector<double> samples(SAMPLE_COUNT);
+    if (batch)
+    {
+        for (std::size_t done = 0; done < SAMPLE_COUNT; done += BATCH_SIZE)
+        {
+            generator.Fill(state, samples.data() + done, std::min(BATCH_SIZE, SAMPLE_COUNT - done));
+        }
+    }
+    else
+    {
+        for (auto& sample : samples)
+        {
+            sample = generator.GetRandom(state);
+        }
+    }
+    return samples;
+}
+
+/**
+ * Kolmogorov-Smirnov statistic of a sample against a continuous law.
+ * \param samples The sample, sorted in place.
+ * \param cdf Cumulative distribution function of the law.
+ * \return The largest distance between the empirical and reference CDFs.
+ */
+double
+KsStatistic(std::vector<double>& samples, const Cdf& cdf)
+{
+    std::sort(samples.begin(), samples.end());
+    double n = samples.size();
+    double distance = 0;
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+        double expected = cdf(samples[i]);
+        distance = std::max({distance, (i + 1) / n - expected, expected - i / n});
+    }
+    return distance;
+}
+
+/**
+ * Critical value of the Kolmogorov-Smirnov statistic at the 0.1% level.
+ * \param n Size of the sample.
+ * \return The critical value.
+ */
+double
+KsCriticalValue(std::size_t n)
+{
+    return std::sqrt(-0.5 * std::log(0.001 / 2) / n);
+}
+
+/// A chi-square statistic and its degrees of freedom.
+struct ChiSquare
+{
+    double statistic{0};    ///< The statistic.
+    std::size_t degrees{0}; ///< Degrees of freedom.
+};
+
+/**
+ * Chi-square statistic of observed counts against expected counts. Bins
+ * expected empty are skipped, unless they are not, which fails the test.
+ * \param observed Observed counts.
+ * \param expected Expected counts, of the same size.
+ * \return The statistic, with one degree of freedom less than the bins
+ *         expected non-empty.
+ */
+ChiSquare
+ChiSquareStatistic(const std::vector<double>& observed, const std::vector<double>& expected)
+{
+    ChiSquare chiSquare;
+    std::size_t bins = 0;
+    for (std::size_t i = 0; i < observed.size(); ++i)
+    {
+        if (expected[i] <= 0)
+        {
+            if (observed[i] > 0)
+            {
+                chiSquare.statistic = std::numeric_limits<double>::infinity();
+            }
+            continue;
+        }
+        double difference = observed[i] - expected[i];
+        chiSquare.statistic += difference * difference / expected[i];
+        bins++;
+    }
+    chiSquare.degrees = bins - 1;
+    return chiSquare;
+}
+
+/**
+ * Critical value of the chi-square statistic at the 0.1% level, with the
+ * Wilson-Hilferty approximation.
+ * \param degrees Degrees of freedom.
+ * \return The critical value.
+ */
+double
+ChiSquareCriticalValue(std::size_t degrees)
+{
+    const double z = 3.090; // 99.9% quantile of the standard normal law
+    double k = degrees;
+    double root = 1 - 2 / (9 * k) + z * std::sqrt(2 / (9 * k));
+    return k * root * root * root;
+}
+
+/**
+ * Chi-square statistic of a sample against a continuous law, over bins of equal width
+ * between two bounds plus one bin on each side.
+ * \param samples The sample.
+ * \param cdf Cumulative distribution function of the law.
+ * \param low Lower bound of the bins.
+ * \param high Upper bound of the bins.
+ * \param bins Number of bins between the bounds.
+ * \return The statistic.
+ */
+ChiSquare
+BinnedChiSquare(const std::vector<double>& samples, const Cdf& cdf, double low, double high, std::size_t bins)
+{
+    double width = (high - low) / bins;
+    std::vector<double> observed(bins + 2, 0);
+    for (double sample : samples)
+    {
+        std::size_t bin = 0;
+        if (sample >= high)
+        {
+            bin = bins + 1;
+        }
+        else if (sample >= low)
+        {
+            bin = 1 + std::min(bins - 1, static_cast<std::size_t>((sample - low) / width));
+        }
+        observed[bin]++;
+    }
+
+    std::vector<double> expected(bins + 2);
+    double previous = 0;
+    for (std::size_t bin = 0; bin <= bins; ++bin)
+    {
+        double edge = cdf(low + bin * width);
+        expected[bin] = (edge - previous) * samples.size();
+        previous = edge;
+    }
+    expected[bins + 1] = (1 - previous) * samples.size();
+    return ChiSquareStatistic(observed, expected);
+}
+
+/**
+ * \param batch true for the batch draws.
+ * \return A label of the drawing method.
+ */
+std::string
+ModeName(bool batch)
+{
+    return batch ? "Fill" : "GetRandom";
+}
+
+} // namespace
+
+/**
+ * \ingroup applications-test
+ * Check that RandomGeneratorUniform follows the uniform law.
+ */
+class RandomGeneratorUniformTestCase : public TestCase
+{
+public:
+    /**
+     * \param batch true to draw with Fill, false to draw with GetRandom.
+     */
+    RandomGeneratorUniformTestCase(bool batch);
+
+private:
+    void DoRun() override;
+
+    bool m_batch; ///< Draw with Fill.
+};
+
+RandomGeneratorUniformTestCase::RandomGeneratorUniformTestCase(bool batch)
+    : TestCase("RandomGeneratorUniform follows the uniform law with " + ModeName(batch)),
+      m_batch(batch)
+{
+}
+
+void
+RandomGeneratorUniformTestCase::DoRun()
+{
+    const double min = 2;
+    const double max = 10;
+    RandomGeneratorUniform generator(min, max);
+    std::vector<double> samples = Draw(generator, m_batch, 1);
+
+    auto [smallest, largest] = std::minmax_element(samples.begin(), samples.end());
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(*smallest, min, "Sample below the minimum");
+    NS_TEST_ASSERT_MSG_LT(*largest, max, "Sample above the maximum");
+
+    Cdf cdf = [min, max](double x) { return std::min(1.0, std::max(0.0, (x - min) / (max - min))); };
+    ChiSquare chiSquare = BinnedChiSquare(samples, cdf, min, max, 40);
+    NS_TEST_ASSERT_MSG_LT(chiSquare.statistic,
+                          ChiSquareCriticalValue(chiSquare.degrees),
+                          "Chi-square test failed");
+    NS_TEST_ASSERT_MSG_LT(KsStatistic(samples, cdf),
+                          KsCriticalValue(samples.size()),
+                          "Kolmogorov-Smirnov test failed");
+}
+
+/**
+ * \ingroup applications-test
+ * Check that RandomGeneratorNormal follows the normal law truncated to
+ * [min, max], without any mass at the bounds.
+ */
+class RandomGeneratorNormalTestCase : public TestCase
+{
+public:
+    /**
+     * \param batch true to draw with Fill, false to draw with GetRandom.
+     * \param window Description of the window.
+     * \param min Lower bound.
+     * \param max Upper bound.
+     * \param mean Mean of the law before truncation.
+     * \param stdDev Standard deviation of the law before truncation.
+     */
+    RandomGeneratorNormalTestCase(bool batch,
+                                  const std::string& window,
+                                  double min,
+                                  double max,
+                                  double mean,
+                                  double stdDev);
+
+private:
+    void DoRun() override;
+
+    bool m_batch;    ///< Draw with Fill.
+    double m_min;    ///< Lower bound.
+    double m_max;    ///< Upper bound.
+    double m_mean;   ///< Mean before truncation.
+    double m_stdDev; ///< Standard deviation before truncation.
+};
+
+RandomGeneratorNormalTestCase::RandomGeneratorNormalTestCase(bool batch,
+                                                             const std::string& window,
+                                                             double min,
+                                                             double max,
+                                                             double mean,
+                                                             double stdDev)
+    : TestCase("RandomGeneratorNormal follows the normal law truncated to " + window + " with " +
+               ModeName(batch)),
+      m_batch(batch),
+      m_min(min),
+      m_max(max),
+      m_mean(mean),
+      m_stdDev(stdDev)
+{
+}
+
+void
+RandomGeneratorNormalTestCase::DoRun()
+{
+    RandomGeneratorNormal generator(m_min, m_max, m_mean, m_stdDev);
+    std::vector<double> samples = Draw(generator, m_batch, 2);
+
+    auto atBounds = std::count_if(samples.begin(), samples.end(), [this](double x) {
+        return x <= m_min || x >= m_max;
+    });
+    NS_TEST_ASSERT_MSG_EQ(atBounds, 0, "Samples piled up at the bounds");
+
+    // Truncated CDF, from the upper tail of the law when the window is above
+    // the mean so that far windows keep their precision
+    double alpha = (m_min - m_mean) / m_stdDev;
+    double beta = (m_max - m_mean) / m_stdDev;
+    Cdf cdf;
+    if (alpha > 0)
+    {
+        double tailMin = std::erfc(alpha / M_SQRT2);
+        double tailMax = std::erfc(beta / M_SQRT2);
+        cdf = [=](double x) {
+            double tail = std::erfc((x - m_mean) / (m_stdDev * M_SQRT2));
+            return std::min(1.0, std::max(0.0, (tailMin - tail) / (tailMin - tailMax)));
+        };
+    }
+    else
+    {
+        double lower = std::erfc(-alpha / M_SQRT2);
+        double upper = std::erfc(-beta / M_SQRT2);
+        cdf = [=](double x) {
+            double below = std::erfc((m_mean - x) / (m_stdDev * M_SQRT2));
+            return std::min(1.0, std::max(0.0, (below - lower) / (upper - lower)));
+        };
+    }
+
+    // Bins over the window, or over 3 standard deviations around the mean
+    // when the window is wider
+    double low = std::max(m_min, m_mean - 3 * m_stdDev);
+    double high = std::min(m_max, m_mean + 3 * m_stdDev);
+    if (high <= low)
+    {
+        low = m_min;
+        high = m_max;
+    }
+    ChiSquare chiSquare = BinnedChiSquare(samples, cdf, low, high, 30);
+    NS_TEST_ASSERT_MSG_LT(chiSquare.statistic,
+                          ChiSquareCriticalValue(chiSquare.degrees),
+                          "Chi-square test failed");
+    NS_TEST_ASSERT_MSG_LT(KsStatistic(samples, cdf),
+                          KsCriticalValue(samples.size()),
+                          "Kolmogorov-Smirnov test failed");
+
+    // The bins leave out the tails, which the Ziggurat draws apart: count
+    // the samples beyond its start, 3.442619855899 standard deviations away
+    double tailLow = m_mean - 3.442619855899 * m_stdDev;
+    double tailHigh = m_mean + 3.442619855899 * m_stdDev;
+    double tailProbability = cdf(tailLow) + 1 - cdf(tailHigh);
+    auto inTails = std::count_if(samples.begin(), samples.end(), [=](double x) {
+        return x < tailLow || x > tailHigh;
+    });
+    double expected = tailProbability * samples.size();
+    NS_TEST_ASSERT_MSG_EQ_TOL(inTails,
+                              expected,
+                              5 * std::sqrt(expected * (1 - tailProbability)) + 1,
+                              "Wrong number of samples in the tails");
+}
+
+/**
+ * \ingroup applications-test
+ * Check that RandomGeneratorDist draws its values with their probabilities.
+ */
+class RandomGeneratorDistTestCase : public TestCase
+{
+public:
+    /**
+     * \param batch true to draw with Fill, false to draw with GetRandom.
+     * \param bins Number of values of the distribution.
+     */
+    RandomGeneratorDistTestCase(bool batch, std::size_t bins);
+
+private:
+    void DoRun() override;
+
+    bool m_batch;       ///< Draw with Fill.
+    std::size_t m_bins; ///< Number of values.
+};
+
+RandomGeneratorDistTestCase::RandomGeneratorDistTestCase(bool batch, std::size_t bins)
+    : TestCase("RandomGeneratorDist with " + std::to_string(bins) +
+               " values follows its probabilities with " + ModeName(batch)),
+      m_batch(batch),
+      m_bins(bins)
+{
+}
+
+void
+RandomGeneratorDistTestCase::DoRun()
+{
+    // Uneven, unnormalized weights, with one value that must never be drawn
+    std::vector<std::pair<double, double>> distribution;
+    double total = 0;
+    for (std::size_t i = 0; i < m_bins; ++i)
+    {
+        double weight = (i == 1) ? 0 : 1 + (i * 7919 % 13);
+        distribution.emplace_back(100 + 10 * i, weight);
+        total += weight;
+    }
+    RandomGeneratorDist generator(distribution);
+    std::vector<double> samples = Draw(generator, m_batch, 3);
+
+    std::map<double, double> counts;
+    for (double sample : samples)
+    {
+        counts[sample]++;
+    }
+
+    std::vector<double> observed;
+    std::vector<double> expected;
+    for (const auto& [value, weight] : distribution)
+    {
+        if (weight == 0)
+        {
+            NS_TEST_ASSERT_MSG_EQ((counts.find(value) == counts.end()),
+                                  true,
+                                  "Value of probability 0 drawn");
+            continue;
+        }
+        observed.push_back(counts[value]);
+        expected.push_back(weight / total * samples.size());
+        counts.erase(value);
+    }
+    NS_TEST_ASSERT_MSG_EQ(counts.empty(), true, "Value outside the distribution drawn");
+    ChiSquare chiSquare = ChiSquareStatistic(observed, expected);
+    NS_TEST_ASSERT_MSG_LT(chiSquare.statistic,
+                          ChiSquareCriticalValue(chiSquare.degrees),
+                          "Chi-square test failed");
+}
+
+/**
+ * \ingroup applications-test
+ * Check that RandomGeneratorJoint draws its cells with their weights, and
+ * each pair inside its cell.
+ */
+class RandomGeneratorJointTestCase : public TestCase
+{
+public:
+    RandomGeneratorJointTestCase();
+
+private:
+    void DoRun() override;
+};
+
+RandomGeneratorJointTestCase::RandomGeneratorJointTestCase()
+    : TestCase("RandomGeneratorJoint follows its cell weights")
+{
+}
+
+void
+RandomGeneratorJointTestCase::DoRun()
+{
+    // Large payloads come with short intervals and small payloads with long
+    // ones, with cells that must never be drawn
+    std::vector<double> sizeEdges{100, 500, 1000, 1448};
+    std::vector<double> timeEdges{0, 0.001, 0.01, 0.1, 1};
+    std::vector<double> weights{0, 1, 6, 3, 2, 5, 4, 0, 9, 2, 0, 0};
+    RandomGeneratorJoint generator(sizeEdges, timeEdges, weights);
+
+    RngSeedManager::SetSeed(1);
+    RngSeedManager::SetRun(1);
+    RandomGeneratorState state;
+    state.Seed(7);
+
+    std::size_t columns = timeEdges.size() - 1;
+    std::vector<double> counts(weights.size(), 0);
+    std::size_t outside = 0;
+    for (std::size_t i = 0; i < SAMPLE_COUNT; ++i)
+    {
+        auto [size, time] = generator.GetRandom(state);
+        auto row = std::upper_bound(sizeEdges.begin(), sizeEdges.end(), size) - sizeEdges.begin() - 1;
+        auto column = std::upper_bound(timeEdges.begin(), timeEdges.end(), time) - timeEdges.begin() - 1;
+        if (row < 0 || row >= static_cast<long>(sizeEdges.size() - 1) || column < 0 ||
+            column >= static_cast<long>(columns))
+        {
+            outside++;
+            continue;
+        }
+        counts[row * columns + column]++;
+    }
+    NS_TEST_ASSERT_MSG_EQ(outside, 0U, "Pair drawn outside the histogram");
+
+    double total = 0;
+    for (double weight : weights)
+    {
+        total += weight;
+    }
+    std::vector<double> expected;
+    for (std::size_t cell = 0; cell < weights.size(); ++cell)
+    {
+        if (weights[cell] == 0)
+        {
+            NS_TEST_ASSERT_MSG_EQ(counts[cell], 0, "Cell of weight 0 drawn");
+        }
+        expected.push_back(weights[cell] / total * SAMPLE_COUNT);
+    }
+    ChiSquare chiSquare = ChiSquareStatistic(counts, expected);
+    NS_TEST_ASSERT_MSG_LT(chiSquare.statistic,
+                          ChiSquareCriticalValue(chiSquare.degrees),
+                          "Chi-square test failed");
+
+    // Within a wide cell, the positions are not on a coarse lattice and the
+    // two components are uncorrelated
+    RandomGeneratorJoint wide({0, 202720}, {0, 1}, {1});
+    std::vector<double> firsts(SAMPLE_COUNT);
+    std::vector<double> seconds(SAMPLE_COUNT);
+    for (std::size_t i = 0; i < SAMPLE_COUNT; ++i)
+    {
+        std::tie(firsts[i], seconds[i]) = wide.GetRandom(state);
+    }
+    double meanFirst = std::accumulate(firsts.begin(), firsts.end(), 0.0) / SAMPLE_COUNT;
+    double meanSecond = std::accumulate(seconds.begin(), seconds.end(), 0.0) / SAMPLE_COUNT;
+    double covariance = 0;
+    double varianceFirst = 0;
+    double varianceSecond = 0;
+    for (std::size_t i = 0; i < SAMPLE_COUNT; ++i)
+    {
+        covariance += (firsts[i] - meanFirst) * (seconds[i] - meanSecond);
+        varianceFirst += (firsts[i] - meanFirst) * (firsts[i] - meanFirst);
+        varianceSecond += (seconds[i] - meanSecond) * (seconds[i] - meanSecond);
+    }
+    NS_TEST_ASSERT_MSG_LT(std::abs(covariance / std::sqrt(varianceFirst * varianceSecond)),
+                          0.02,
+                          "Components of a cell correlated");
+    for (auto* samples : {&firsts, &seconds})
+    {
+        std::sort(samples->begin(), samples->end());
+        std::size_t distinct = std::unique(samples->begin(), samples->end()) - samples->begin();
+        NS_TEST_ASSERT_MSG_GT(distinct, 65536U, "Positions within a cell on a 16-bit lattice");
+    }
+}
+
+/**
+ * \ingroup applications-test
+ * Check that a continuous generator follows its reference law.
+ */
+class RandomGeneratorLawTestCase : public TestCase
+{
+public:
+    /**
+     * \param batch true to draw with Fill, false to draw with GetRandom.
+     * \param name Description of the generator.
+     * \param generator The generator.
+     * \param cdf Cumulative distribution function of the reference law.
+     * \param low Lower bound of the chi-square bins.
+     * \param high Upper bound of the chi-square bins.
+     */
+    RandomGeneratorLawTestCase(bool batch,
+                               const std::string& name,
+                               std::shared_ptr<RandomGenerator> generator,
+                               Cdf cdf,
+                               double low,
+                               double high);
+
+private:
+    void DoRun() override;
+
+    bool m_batch;                                 ///< Draw with Fill.
+    std::shared_ptr<RandomGenerator> m_generator; ///< The generator.
+    Cdf m_cdf;                                    ///< Reference law.
+    double m_low;                                 ///< Lower bound of the bins.
+    double m_high;                                ///< Upper bound of the bins.
+};
+
+RandomGeneratorLawTestCase::RandomGeneratorLawTestCase(bool batch,
+                                                       const std::string& name,
+                                                       std::shared_ptr<RandomGenerator> generator,
+                                                       Cdf cdf,
+                                                       double low,
+                                                       double high)
+    : TestCase(name + " follows its law with " + ModeName(batch)),
+      m_batch(batch),
+      m_generator(generator),
+      m_cdf(cdf),
+      m_low(low),
+      m_high(high)
+{
+}
+
+void
+RandomGeneratorLawTestCase::DoRun()
+{
+    std::vector<double> samples = Draw(*m_generator, m_batch, 4);
+
+    ChiSquare chiSquare = BinnedChiSquare(samples, m_cdf, m_low, m_high, 30);
+    NS_TEST_ASSERT_MSG_LT(chiSquare.statistic,
+                          ChiSquareCriticalValue(chiSquare.degrees),
+                          "Chi-square test failed");
+    NS_TEST_ASSERT_MSG_LT(KsStatistic(samples, m_cdf),
+                          KsCriticalValue(samples.size()),
+                          "Kolmogorov-Smirnov test failed");
+}
+
+/**
+ * Cumulative distribution function of a law truncated to [min, max].
+ * \param cdf Cumulative distribution function of the law.
+ * \param min Lower bound.
+ * \param max Upper bound.
+ * \return The truncated function.
+ */
+Cdf
+Truncate(Cdf cdf, double min, double max)
+{
+    double low = cdf(min);
+    double high = cdf(max);
+    return [=](double x) { return std::min(1.0, std::max(0.0, (cdf(x) - low) / (high - low))); };
+}
+
+/**
+ * \ingroup applications-test
+ * Check that RandomGeneratorReplay reads the sequence in order from the
+ * start offset of each state and wraps around at the end, that states
+ * sharing a mapping read independently, and that the two replays of a
+ * SubFlow state stay paired.
+ */
+class RandomGeneratorReplayTestCase : public TestCase
+{
+public:
+    RandomGeneratorReplayTestCase();
+
+private:
+    void DoRun() override;
+};
+
+RandomGeneratorReplayTestCase::RandomGeneratorReplayTestCase()
+    : TestCase("RandomGeneratorReplay reads from its start offset and wraps around")
+{
+}
+
+void
+RandomGeneratorReplayTestCase::DoRun()
+{
+    RngSeedManager::SetSeed(1);
+    RngSeedManager::SetRun(1);
+
+    // Sample i is i
+    constexpr std::size_t size = 10;
+    std::vector<double> samples(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        samples[i] = i;
+    }
+    std::string filename = CreateTempDirFilename("replay.bin");
+    RandomGeneratorReplay::WriteSampleFile(filename, samples);
+    RandomGeneratorReplay first(filename);
+    RandomGeneratorReplay second(filename);
+    NS_TEST_ASSERT_MSG_EQ(first.GetSize(), size, "Wrong number of samples");
+
+    // A start beyond the size is taken modulo the size
+    RandomGeneratorState state;
+    state.Seed(1);
+    NS_TEST_ASSERT_MSG_EQ(state.start, RandomGeneratorState::UNSET, "Start set by Seed");
+    state.start = 2 * size + 7;
+    for (double expected : {7, 8, 9, 0, 1})
+    {
+        NS_TEST_ASSERT_MSG_EQ(first.GetRandom(state), expected, "Wrong sample around the end");
+    }
+    std::vector<double> batch(2 * size + 3);
+    first.Fill(state, batch.data(), batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(batch[i], (2 + i) % size, "Wrong batch sample " << i);
+    }
+
+    // States sharing the mapping and the start offset read the same
+    // samples, whatever the interleaving of their reads
+    RandomGeneratorState a;
+    RandomGeneratorState b;
+    a.Seed(2);
+    b.Seed(3);
+    a.start = 4;
+    b.start = 4;
+    for (std::size_t i = 0; i < 2 * size; ++i)
+    {
+        double expected = (4 + i) % size;
+        NS_TEST_ASSERT_MSG_EQ(first.GetRandom(a), expected, "First state skipped a sample");
+        NS_TEST_ASSERT_MSG_EQ(second.GetRandom(b), expected, "Second state skipped a sample");
+    }
+
+    // Without a start offset, each state reads in order from a random one
+    RandomGeneratorState random;
+    random.Seed(4);
+    double previous = first.GetRandom(random);
+    for (std::size_t i = 0; i < 2 * size; ++i)
+    {
+        double next = second.GetRandom(random);
+        NS_TEST_ASSERT_MSG_EQ(next, std::fmod(previous + 1, size), "Random start read out of order");
+        previous = next;
+    }
+
+    // Payload sizes and inter-packet times recorded together: size i comes
+    // with time i in every SubFlow state, each state reading from its own
+    // offset
+    constexpr std::size_t captureSize = 1000;
+    std::vector<double> sizes(captureSize);
+    std::vector<double> times(captureSize);
+    for (std::size_t i = 0; i < captureSize; ++i)
+    {
+        sizes[i] = 100 + i;
+        times[i] = 0.001 * i;
+    }
+    std::string sizeFile = CreateTempDirFilename("sizes.bin");
+    std::string timeFile = CreateTempDirFilename("times.bin");
+    RandomGeneratorReplay::WriteSampleFile(sizeFile, sizes);
+    RandomGeneratorReplay::WriteSampleFile(timeFile, times);
+    SubFlow subFlow(1, RandomGeneratorReplay(sizeFile), RandomGeneratorReplay(timeFile));
+
+    std::vector<uint32_t> firstSizes;
+    for (int64_t stream : {10, 12, 14})
+    {
+        SubFlow::State subFlowState;
+        NS_TEST_ASSERT_MSG_EQ(subFlow.AssignStreams(subFlowState, stream), 2, "Wrong stream count");
+        NS_TEST_ASSERT_MSG_EQ(subFlowState.payloadSize.start,
+                              subFlowState.interPacketTime.start,
+                              "Replays of a state not paired");
+        for (std::size_t i = 0; i < 2 * captureSize; ++i)
+        {
+            SubFlow::NextPacket next = subFlow.GetNextPacket(subFlowState);
+            NS_TEST_ASSERT_MSG_EQ_TOL(next.interPacketTime,
+                                      0.001 * (next.payloadSize - 100),
+                                      1e-9,
+                                      "Payload size and inter-packet time not paired");
+            if (i == 0)
+            {
+                firstSizes.push_back(next.payloadSize);
+            }
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ((firstSizes[0] != firstSizes[1] || firstSizes[1] != firstSizes[2]),
+                          true,
+                          "SubFlow states share their start offset");
+}
+
+/**
+ * \ingroup applications-test
+ * Generator returning 0, 1, 2... from each state, counting the instances
+ * built.
+ */
+class CountingGenerator : public RandomGenerator
+{
+public:
+    CountingGenerator()
+    {
+        s_built++;
+    }
+
+    double GetRandom() const override
+    {
+        return GetRandom(m_state);
+    }
+
+    double GetRandom(RandomGeneratorState& state) const override
+    {
+        if (state.position == RandomGeneratorState::UNSET)
+        {
+            state.position = 0;
+        }
+        return state.position++;
+    }
+
+    static std::size_t s_built; ///< Number of instances built.
+
+private:
+    mutable RandomGeneratorState m_state; ///< State of GetRandom().
+};
+
+std::size_t CountingGenerator::s_built = 0;
+
+/**
+ * \ingroup applications-test
+ * Check that a Markov-modulated SubFlow follows its transition matrix and
+ * the dwell time law of each state, and that a state change neither
+ * rebuilds the generators nor restarts the sequence of a state.
+ */
+class SubFlowMarkovTestCase : public TestCase
+{
+public:
+    SubFlowMarkovTestCase();
+
+private:
+    void DoRun() override;
+};
+
+SubFlowMarkovTestCase::SubFlowMarkovTestCase()
+    : TestCase("A Markov-modulated SubFlow follows its transitions and dwell times")
+{
+}
+
+void
+SubFlowMarkovTestCase::DoRun()
+{
+    RngSeedManager::SetSeed(1);
+    RngSeedManager::SetRun(1);
+
+    // Three states with exponential dwell times, a forbidden transition per
+    // row and a state which may stay in place
+    std::vector<double> means{1, 2, 0.5};
+    std::vector<std::vector<double>> weights{{0, 1, 3}, {2, 0, 2}, {1, 1, 2}};
+    std::vector<SubFlow::ModulationState> states;
+    for (std::size_t i = 0; i < means.size(); ++i)
+    {
+        std::vector<std::pair<double, double>> row;
+        for (std::size_t j = 0; j < weights[i].size(); ++j)
+        {
+            row.emplace_back(j, weights[i][j]);
+        }
+        auto packets = std::make_shared<SubFlow>(
+            i,
+            std::make_shared<CountingGenerator>(),
+            RandomGeneratorDist(std::vector<std::pair<double, double>>{{0.1, 1}}));
+        states.push_back({packets, RandomGeneratorExponential(means[i]), RandomGeneratorDist(row)});
+    }
+    SubFlow subFlow(1, std::move(states));
+    std::size_t built = CountingGenerator::s_built;
+
+    SubFlow::Modulation modulation;
+    NS_TEST_ASSERT_MSG_EQ(SubFlow::AssignStreams(modulation, 3), 1, "Wrong stream count");
+    SubFlow::State state;
+    NS_TEST_ASSERT_MSG_EQ(subFlow.AssignStreams(state, 20), 6, "Wrong stream count");
+
+    std::vector<std::vector<double>> dwellTimes(means.size());
+    dwellTimes[0].push_back(subFlow.StartModulation(modulation));
+    NS_TEST_ASSERT_MSG_EQ(modulation.state, 0U, "The modulation does not start in state 0");
+
+    std::vector<std::vector<double>> transitions(means.size(),
+                                                 std::vector<double>(means.size(), 0));
+    std::vector<uint32_t> visits(means.size(), 0);
+    for (std::size_t i = 0; i < SAMPLE_COUNT; ++i)
+    {
+        // The sequence of each state resumes where the previous visit stopped
+        uint32_t current = modulation.state;
+        NS_TEST_ASSERT_MSG_EQ(subFlow.GetNextPacket(state, current).payloadSize,
+                              visits[current],
+                              "Sequence of state " << current << " restarted or shared");
+        visits[current]++;
+
+        double dwellTime = subFlow.NextModulationState(modulation);
+        transitions[current][modulation.state]++;
+        dwellTimes[modulation.state].push_back(dwellTime);
+    }
+    NS_TEST_ASSERT_MSG_EQ(CountingGenerator::s_built, built, "Generators rebuilt on a state change");
+
+    for (std::size_t i = 0; i < means.size(); ++i)
+    {
+        double total = std::accumulate(weights[i].begin(), weights[i].end(), 0.0);
+        double leaving = std::accumulate(transitions[i].begin(), transitions[i].end(), 0.0);
+        std::vector<double> expected;
+        for (double weight : weights[i])
+        {
+            expected.push_back(weight / total * leaving);
+        }
+        ChiSquare chiSquare = ChiSquareStatistic(transitions[i], expected);
+        NS_TEST_ASSERT_MSG_LT(chiSquare.statistic,
+                              ChiSquareCriticalValue(chiSquare.degrees),
+                              "Chi-square test failed on the transitions from state " << i);
+
+        double mean = means[i];
+        Cdf exponential = [mean](double x) { return x < 0 ? 0 : -std::expm1(-x / mean); };
+        NS_TEST_ASSERT_MSG_LT(KsStatistic(dwellTimes[i], exponential),
+                              KsCriticalValue(dwellTimes[i].size()),
+                              "KS test failed on the dwell times of state " << i);
+    }
+}
+
+/**
+ * \ingroup applications-test
+ * Check that a SubFlow draws ahead by blocks into the rings of a State
+ * without changing the sequence of each generator, and that the rings are
+ * discarded on a reseed or when another SubFlow uses the State.
+ */
+class SubFlowRingTestCase : public TestCase
+{
+public:
+    SubFlowRingTestCase();
+
+private:
+    void DoRun() override;
+};
+
+SubFlowRingTestCase::SubFlowRingTestCase()
+    : TestCase("A SubFlow draws ahead by blocks, keeping the sequence of each generator")
+{
+}
+
+void
+SubFlowRingTestCase::DoRun()
+{
+    const std::size_t ringSize = SubFlow::State::RING_SIZE;
+    SubFlow subFlow(1, std::make_shared<CountingGenerator>(), std::make_shared<CountingGenerator>());
+    SubFlow::State state;
+    subFlow.AssignStreams(state, 30);
+
+    // The first delay is read alone, so that the times run one ahead
+    NS_TEST_ASSERT_MSG_EQ(subFlow.GetInterPacketTime(state), 0, "Wrong first time");
+    NS_TEST_ASSERT_MSG_EQ(state.interPacketTime.position,
+                          static_cast<uint64_t>(ringSize),
+                          "Ring not filled by a block");
+    for (std::size_t i = 0; i < 3 * ringSize; ++i)
+    {
+        SubFlow::NextPacket next = subFlow.GetNextPacket(state);
+        NS_TEST_ASSERT_MSG_EQ(next.payloadSize,
+                              static_cast<uint32_t>(i),
+                              "Payload sizes out of sequence");
+        NS_TEST_ASSERT_MSG_EQ(next.interPacketTime, i + 1.0, "Inter-packet times out of sequence");
+        NS_TEST_ASSERT_MSG_EQ(state.payloadSize.position,
+                              static_cast<uint64_t>((i / ringSize + 1) * ringSize),
+                              "Payload sizes not drawn by blocks");
+    }
+
+    // A reseed restarts the sequences instead of reading the samples ahead
+    state.Seed(30);
+    NS_TEST_ASSERT_MSG_EQ(subFlow.GetPayloadSize(state), 0U, "Samples kept across a reseed");
+
+    // Another SubFlow reads from its own generators
+    SubFlow other(2,
+                  RandomGeneratorDist(std::vector<std::pair<double, double>>{{7, 1}}),
+                  RandomGeneratorDist(std::vector<std::pair<double, double>>{{0.5, 1}}));
+    SubFlow::NextPacket next = other.GetNextPacket(state);
+    NS_TEST_ASSERT_MSG_EQ(next.payloadSize, 7U, "Samples of another SubFlow read");
+    NS_TEST_ASSERT_MSG_EQ(next.interPacketTime, 0.5, "Samples of another SubFlow read");
+}
+
+/**
+ * \ingroup applications-test
+ * Statistical conformance of the random generators, for the scalar and the
+ * batch draws. Changes to the samplers must keep these tests passing.
+ */
+class RandomGeneratorTestSuite : public TestSuite
+{
+public:
+    RandomGeneratorTestSuite();
+
+private:
+    /**
+     * Add the test cases of the continuous laws.
+     * \param batch true to draw with Fill, false to draw with GetRandom.
+     */
+    void AddLawTestCases(bool batch);
+};
+
+RandomGeneratorTestSuite::RandomGeneratorTestSuite()
+    : TestSuite("applications-random-generator", Type::UNIT)
+{
+    for (bool batch : {false, true})
+    {
+        AddTestCase(new RandomGeneratorUniformTestCase(batch), TestCase::Duration::QUICK);
+        // Bounds far from the mean, then windows covering each sampler:
+        // mostly the body (payload size of the Tapo C200 sub-flow 3), a
+        // narrow window around the mean, and windows far in either tail
+        AddTestCase(new RandomGeneratorNormalTestCase(batch, "10 std-devs", -2200, 3800, 800, 300),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new RandomGeneratorNormalTestCase(batch,
+                                                      "a bound near the mean",
+                                                      2004,
+                                                      202720,
+                                                      7761.412,
+                                                      11299.521),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new RandomGeneratorNormalTestCase(batch, "a narrow window", 790, 830, 800, 300),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new RandomGeneratorNormalTestCase(batch, "the upper tail", 3200, 3500, 800, 300),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new RandomGeneratorNormalTestCase(batch, "the lower tail", -1900, -1600, 800, 300),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new RandomGeneratorDistTestCase(batch, 8), TestCase::Duration::QUICK);
+        AddLawTestCases(batch);
+        AddTestCase(new RandomGeneratorDistTestCase(batch, 1000), TestCase::Duration::QUICK);
+    }
+    AddTestCase(new RandomGeneratorJointTestCase(), TestCase::Duration::QUICK);
+    AddTestCase(new RandomGeneratorReplayTestCase(), TestCase::Duration::QUICK);
+    AddTestCase(new SubFlowMarkovTestCase(), TestCase::Duration::QUICK);
+    AddTestCase(new SubFlowRingTestCase(), TestCase::Duration::QUICK);
+}
+
+void
+RandomGeneratorTestSuite::AddLawTestCases(bool batch)
+{
+    Cdf exponential = [](double x) { return x < 0 ? 0 : -std::expm1(-x / 0.05); };
+    AddTestCase(new RandomGeneratorLawTestCase(batch,
+                                               "RandomGeneratorExponential",
+                                               std::make_shared<RandomGeneratorExponential>(0.05),
+                                               exponential,
+                                               0,
+                                               0.2),
+                TestCase::Duration::QUICK);
+    AddTestCase(new RandomGeneratorLawTestCase(
+                    batch,
+                    "Truncated RandomGeneratorExponential",
+                    std::make_shared<RandomGeneratorExponential>(0.05, 0.02, 0.1),
+                    Truncate(exponential, 0.02, 0.1),
+                    0.02,
+                    0.1),
+                TestCase::Duration::QUICK);
+
+    Cdf pareto = [](double x) { return x < 0.01 ? 0 : 1 - std::pow(0.01 / x, 1.5); };
+    AddTestCase(new RandomGeneratorLawTestCase(batch,
+                                               "RandomGeneratorPareto",
+                                               std::make_shared<RandomGeneratorPareto>(0.01, 1.5),
+                                               pareto,
+                                               0.01,
+                                               0.1),
+                TestCase::Duration::QUICK);
+    AddTestCase(new RandomGeneratorLawTestCase(
+                    batch,
+                    "Truncated RandomGeneratorPareto",
+                    std::make_shared<RandomGeneratorPareto>(0.01, 1.5, 0.05, 5),
+                    Truncate(pareto, 0.05, 5),
+                    0.05,
+                    1),
+                TestCase::Duration::QUICK);
+
+    Cdf weibull = [](double x) { return x < 0 ? 0 : -std::expm1(-std::pow(x / 800, 2)); };
+    AddTestCase(new RandomGeneratorLawTestCase(batch,
+                                               "RandomGeneratorWeibull",
+                                               std::make_shared<RandomGeneratorWeibull>(800, 2),
+                                               weibull,
+                                               0,
+                                               2000),
+                TestCase::Duration::QUICK);
+    AddTestCase(new RandomGeneratorLawTestCase(
+                    batch,
+                    "Truncated RandomGeneratorWeibull",
+                    std::make_shared<RandomGeneratorWeibull>(800, 2, 40, 1448),
+                    Truncate(weibull, 40, 1448),
+                    40,
+                    1448),
+                TestCase::Duration::QUICK);
+
+    Cdf lognormal = [](double x) {
+        return x <= 0 ? 0 : 0.5 * std::erfc((6.5 - std::log(x)) / (0.4 * M_SQRT2));
+    };
+    AddTestCase(new RandomGeneratorLawTestCase(batch,
+                                               "RandomGeneratorLognormal",
+                                               std::make_shared<RandomGeneratorLognormal>(6.5, 0.4),
+                                               lognormal,
+                                               200,
+                                               2000),
+                TestCase::Duration::QUICK);
+    AddTestCase(new RandomGeneratorLawTestCase(
+                    batch,
+                    "Truncated RandomGeneratorLognormal",
+                    std::make_shared<RandomGeneratorLognormal>(6.5, 0.4, 0, 1448),
+                    Truncate(lognormal, 0, 1448),
+                    200,
+                    1448),
+                TestCase::Duration::QUICK);
+
+    // Piecewise-linear CDF with a flat part
+    std::vector<std::pair<double, double>> points{{100, 0}, {500, 0.7}, {600, 0.7}, {1448, 1}};
+    Cdf empirical = [points](double x) {
+        if (x < points.front().first)
+        {
+            return 0.0;
+        }
+        for (std::size_t i = 1; i < points.size(); ++i)
+        {
+            if (x < points[i].first)
+            {
+                const auto& [x0, p0] = points[i - 1];
+                const auto& [x1, p1] = points[i];
+                return p0 + (p1 - p0) * (x - x0) / (x1 - x0);
+            }
+        }
+        return 1.0;
+    };
+    AddTestCase(new RandomGeneratorLawTestCase(batch,
+                                               "RandomGeneratorEmpirical",
+                                               std::make_shared<RandomGeneratorEmpirical>(points),
+                                               empirical,
+                                               100,
+                                               1448),
+                TestCase::Duration::QUICK);
+}
+
+/// Static variable for test initialization
+static RandomGeneratorTestSuite g_randomGeneratorTestSuite;
@@ -0,0 +1,495 @@
+#include <ns3/random-generator.h>
+#include <ns3/sub-flow.h>
+#include <ns3/test.h>
+#include <ns3/traffic-profile-loader.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+/**
+ * Write a profile.
+ * \param filename Path of the profile.
+ * \param text JSON text of the profile.
+ */
+void
+WriteProfile(const std::string& filename, const std::string& text)
+{
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    out << text;
+}
+
+/**
+ * Load a profile in a child process, since errors are fatal.
+ * \param filename Path of the profile.
+ * \return The error output of the child if the load aborted, or an empty
+ *         string if the profile is valid.
+ */
+std::string
+LoadError(const std::string& filename)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return "pipe failed";
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        dup2(fds[1], STDERR_FILENO);
+        TrafficProfileLoader::Load(filename);
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string output;
+    char buffer[512];
+    ssize_t count;
+    while ((count = read(fds[0], buffer, sizeof(buffer))) > 0)
+    {
+        output.append(buffer, count);
+    }
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+    {
+        return "";
+    }
+    return output.empty() ? "aborted without a message" : output;
+}
+
+/**
+ * A sub-flow with the given generators.
+ * \param payloadSize JSON of the payload size generator.
+ * \param interPacketTimes JSON of the inter-packet time generator.
+ * \return The JSON text of a profile holding the sub-flow.
+ */
+std::string
+Profile(const std::string& payloadSize, const std::string& interPacketTimes)
+{
+    return R"({"sub-flows": [{"id": 1, "payload-size": )" + payloadSize +
+           R"(, "inter-packet-times": )" + interPacketTimes + "}]}";
+}
+
+/// A valid inter-packet time generator.
+const std::string VALID_TIMES = R"({"type": "uniform", "min": 0.01, "max": 0.02})";
+
+} // namespace
+
+/**
+ * \ingroup applications-test
+ * Check that valid profiles load, with numbers and strings decoded as
+ * JSON defines them.
+ */
+class TrafficProfileLoaderValidTestCase : public TestCase
+{
+public:
+    TrafficProfileLoaderValidTestCase();
+
+private:
+    void DoRun() override;
+};
+
+TrafficProfileLoaderValidTestCase::TrafficProfileLoaderValidTestCase()
+    : TestCase("TrafficProfileLoader loads valid profiles")
+{
+}
+
+void
+TrafficProfileLoaderValidTestCase::DoRun()
+{
+    // Sample i of the replay is 1000 + i
+    std::vector<double> samples{1000, 1001, 1002, 1003};
+    RandomGeneratorReplay::WriteSampleFile(CreateTempDirFilename("sizes.bin"), samples);
+
+    // Every generator type, numbers with exponents and fractions, and a
+    // replay file named with escapes, relative to the profile
+    std::string filename = CreateTempDirFilename("valid.json");
+    WriteProfile(filename, R"({
+  "sub-flows": [
+    {"id": 0,
+     "payload-size": {"type": "uniform", "min": 1E2, "max": 1.5e+2},
+     "inter-packet-times": {"type": "normal", "min": 0, "max": 2e-1, "mean": 0.1, "std-dev": 5E-2}},
+    {"id": 7,
+     "payload-size": {"type": "dist", "distribution": [{"value": 64, "probability": 1},
+                                                       {"value": 1448, "probability": 0}]},
+     "inter-packet-times": {"type": "exponential", "mean": 0.5, "max": 1}},
+    {"id": 65535,
+     "payload-size": {"type": "replay", "file": "\u0073ize\u0073.bin"},
+     "inter-packet-times": {"type": "pareto", "scale": 0.01, "shape": 1.5, "max": 1.0}},
+    {"id": 3,
+     "payload-size": {"type": "empirical", "cdf": [{"value": 100, "cumulative": 0},
+                                                    {"value": 200, "cumulative": 1}]},
+     "inter-packet-times": {"type": "lognormal", "mu": -2, "sigma": 0.5, "min": 0.001, "max": 10}},
+    {"id": 4,
+     "payload-size": {"type": "weibull", "scale": 500, "shape": 2, "max": 1448},
+     "inter-packet-times": {"type": "uniform", "min": -0, "max": 0.25}},
+    {"id": 5,
+     "joint": {"payload-size-edges": [100, 200], "inter-packet-time-edges": [0, 0.5, 1],
+               "weights": [[1, 0]]}},
+    {"id": 6,
+     "markov": {
+       "states": [
+         {"dwell-time": {"type": "uniform", "min": 1, "max": 2},
+          "payload-size": {"type": "uniform", "min": 10, "max": 10},
+          "inter-packet-times": {"type": "uniform", "min": 1, "max": 1}},
+         {"dwell-time": {"type": "exponential", "mean": 5},
+          "joint": {"payload-size-edges": [300, 400], "inter-packet-time-edges": [2, 3],
+                    "weights": [[1]]}}
+       ],
+       "transitions": [[0, 1], [1, 0]]}}
+  ]
+})");
+    std::string error = LoadError(filename);
+    NS_TEST_ASSERT_MSG_EQ(error, "", "Valid profile rejected");
+    if (!error.empty())
+    {
+        return;
+    }
+
+    TrafficProfileLoader::TrafficProfile profile = TrafficProfileLoader::Load(filename);
+    NS_TEST_ASSERT_MSG_EQ(profile.size(), 7U, "Wrong number of sub-flows");
+    std::vector<uint16_t> ids{0, 7, 65535, 3, 4, 5, 6};
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(profile[i]->GetId(), ids[i], "Wrong id of sub-flow " << i);
+        NS_TEST_ASSERT_MSG_EQ(profile[i]->IsModulated(), (i == 6), "Wrong modulation of sub-flow " << i);
+    }
+
+    SubFlow::State state;
+    state.Seed(1);
+    for (int i = 0; i < 1000; ++i)
+    {
+        SubFlow::NextPacket uniform = profile[0]->GetNextPacket(state);
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(uniform.payloadSize, 100U, "1E2 misread");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(uniform.payloadSize, 150U, "1.5e+2 misread");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(uniform.interPacketTime, 0.2, "2e-1 misread");
+
+        SubFlow::NextPacket dist = profile[1]->GetNextPacket(state);
+        NS_TEST_ASSERT_MSG_EQ(dist.payloadSize, 64U, "Value of probability 0 drawn");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(dist.interPacketTime, 1, "Optional max ignored");
+
+        SubFlow::NextPacket replay = profile[2]->GetNextPacket(state);
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(replay.payloadSize, 1000U, "Wrong replay file");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(replay.payloadSize, 1003U, "Wrong replay file");
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(replay.interPacketTime, 0.01, "Pareto below its scale");
+
+        SubFlow::NextPacket empirical = profile[3]->GetNextPacket(state);
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(empirical.payloadSize, 100U, "Empirical below its CDF");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(empirical.payloadSize, 200U, "Empirical above its CDF");
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(empirical.interPacketTime, 0.001, "Optional min ignored");
+
+        SubFlow::NextPacket weibull = profile[4]->GetNextPacket(state);
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(weibull.payloadSize, 1448U, "Optional max ignored");
+
+        SubFlow::NextPacket joint = profile[5]->GetNextPacket(state);
+        NS_TEST_ASSERT_MSG_LT(joint.interPacketTime, 0.5, "Joint cell of weight 0 drawn");
+    }
+
+    // Each state of the Markov sub-flow draws from its own generators
+    SubFlow::State markov;
+    SubFlow::NextPacket first = profile[6]->GetNextPacket(markov, 0);
+    SubFlow::NextPacket second = profile[6]->GetNextPacket(markov, 1);
+    NS_TEST_ASSERT_MSG_EQ(first.payloadSize, 10U, "Wrong first state");
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(second.payloadSize, 300U, "Wrong second state");
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(second.interPacketTime, 2, "Wrong second state");
+}
+
+/**
+ * \ingroup applications-test
+ * Check that an invalid profile is a fatal error naming the file, the line
+ * and the offending element.
+ */
+class TrafficProfileLoaderErrorTestCase : public TestCase
+{
+public:
+    /**
+     * \param name Description of the error.
+     * \param text JSON text of the profile.
+     * \param expected Part of the expected error message.
+     */
+    TrafficProfileLoaderErrorTestCase(const std::string& name,
+                                      const std::string& text,
+                                      const std::string& expected);
+
+private:
+    void DoRun() override;
+
+    std::string m_text;     ///< JSON text of the profile.
+    std::string m_expected; ///< Part of the expected error message.
+};
+
+TrafficProfileLoaderErrorTestCase::TrafficProfileLoaderErrorTestCase(const std::string& name,
+                                                                     const std::string& text,
+                                                                     const std::string& expected)
+    : TestCase("TrafficProfileLoader rejects " + name),
+      m_text(text),
+      m_expected(expected)
+{
+}
+
+void
+TrafficProfileLoaderErrorTestCase::DoRun()
+{
+    std::string filename = CreateTempDirFilename("invalid.json");
+    WriteProfile(filename, m_text);
+    std::string error = LoadError(filename);
+    NS_TEST_ASSERT_MSG_NE(error, "", "Invalid profile accepted");
+    NS_TEST_ASSERT_MSG_NE(error.find(filename + ":"),
+                          std::string::npos,
+                          "The error does not name the file: " << error);
+    NS_TEST_ASSERT_MSG_NE(error.find(m_expected),
+                          std::string::npos,
+                          "Expected '" << m_expected << "' in: " << error);
+}
+
+/**
+ * \ingroup applications-test
+ * Check that profiles are parsed once per path, until the cache is cleared.
+ */
+class TrafficProfileLoaderCacheTestCase : public TestCase
+{
+public:
+    TrafficProfileLoaderCacheTestCase();
+
+private:
+    void DoRun() override;
+};
+
+TrafficProfileLoaderCacheTestCase::TrafficProfileLoaderCacheTestCase()
+    : TestCase("TrafficProfileLoader caches profiles by path")
+{
+}
+
+void
+TrafficProfileLoaderCacheTestCase::DoRun()
+{
+    std::string filename = CreateTempDirFilename("cached.json");
+    std::string other = CreateTempDirFilename("other.json");
+    WriteProfile(filename, Profile(R"({"type": "uniform", "min": 10, "max": 10})", VALID_TIMES));
+    WriteProfile(other, Profile(R"({"type": "uniform", "min": 30, "max": 30})", VALID_TIMES));
+
+    TrafficProfileLoader::ClearCache();
+    TrafficProfileLoader::TrafficProfile first = TrafficProfileLoader::Load(filename);
+    TrafficProfileLoader::TrafficProfile otherProfile = TrafficProfileLoader::Load(other);
+    NS_TEST_ASSERT_MSG_EQ((first[0] != otherProfile[0]), true, "Two paths share a profile");
+
+    // A change of the file is not seen until the cache is cleared
+    WriteProfile(filename, Profile(R"({"type": "uniform", "min": 20, "max": 20})", VALID_TIMES));
+    TrafficProfileLoader::TrafficProfile second = TrafficProfileLoader::Load(filename);
+    NS_TEST_ASSERT_MSG_EQ((first[0] == second[0]), true, "Profile parsed twice");
+    SubFlow::State state;
+    NS_TEST_ASSERT_MSG_EQ(second[0]->GetPayloadSize(state), 10U, "Cached profile changed");
+
+    TrafficProfileLoader::ClearCache();
+    TrafficProfileLoader::TrafficProfile third = TrafficProfileLoader::Load(filename);
+    NS_TEST_ASSERT_MSG_EQ((first[0] != third[0]), true, "Cache not cleared");
+    NS_TEST_ASSERT_MSG_EQ(third[0]->GetPayloadSize(state), 20U, "File not read again");
+    TrafficProfileLoader::ClearCache();
+}
+
+/**
+ * \ingroup applications-test
+ * Tests of TrafficProfileLoader.
+ */
+class TrafficProfileLoaderTestSuite : public TestSuite
+{
+public:
+    TrafficProfileLoaderTestSuite();
+
+private:
+    /**
+     * Add a test case expecting an error.
+     * \param name Description of the error.
+     * \param text JSON text of the profile.
+     * \param expected Part of the expected error message.
+     */
+    void AddError(const std::string& name, const std::string& text, const std::string& expected);
+};
+
+void
+TrafficProfileLoaderTestSuite::AddError(const std::string& name,
+                                        const std::string& text,
+                                        const std::string& expected)
+{
+    AddTestCase(new TrafficProfileLoaderErrorTestCase(name, text, expected),
+                TestCase::Duration::QUICK);
+}
+
+TrafficProfileLoaderTestSuite::TrafficProfileLoaderTestSuite()
+    : TestSuite("applications-traffic-profile-loader", Type::UNIT)
+{
+    AddTestCase(new TrafficProfileLoaderValidTestCase(), TestCase::Duration::QUICK);
+    AddTestCase(new TrafficProfileLoaderCacheTestCase(), TestCase::Duration::QUICK);
+
+    std::string uniform = R"({"type": "uniform", "min": 100, "max": 200})";
+
+    // Keys
+    AddError("an unknown key",
+             R"({"sub-flows": [{"id": 1, "payload-size": )" + uniform +
+                 R"(, "inter-packet-times": )" + VALID_TIMES + R"(, "priority": 2}]})",
+             "sub-flows[0]: unknown key 'priority'");
+    AddError("a misspelt sub-flow key",
+             R"({"sub-flows": [{"id": 1, "payload-sizes": )" + uniform +
+                 R"(, "inter-packet-times": )" + VALID_TIMES + "}]}",
+             "unknown key 'payload-sizes' (did you mean 'payload-size'?)");
+    AddError("a misspelt distribution key",
+             Profile(R"({"type": "dist", "distribution": [{"value": 64, "prabability": 1}]})",
+                     VALID_TIMES),
+             "unknown key 'prabability' (did you mean 'probability'?)");
+    AddError("a missing key",
+             R"({"sub-flows": [{"id": 1, "payload-size": )" + uniform + "}]}",
+             "sub-flows[0]: missing key 'inter-packet-times'");
+    AddError("a missing generator field",
+             Profile(R"({"type": "uniform", "min": 100})", VALID_TIMES),
+             "sub-flows[0].payload-size: missing key 'max'");
+    AddError("an unknown generator type",
+             Profile(R"({"type": "unifrom", "min": 100, "max": 200})", VALID_TIMES),
+             "unknown type 'unifrom' (did you mean 'uniform'?)");
+    AddError("an empty profile", R"({"sub-flows": []})", "the profile has no sub-flow");
+
+    // Types and values
+    AddError("a string id",
+             R"({"sub-flows": [{"id": "1", "payload-size": )" + uniform +
+                 R"(, "inter-packet-times": )" + VALID_TIMES + "}]}",
+             "sub-flows[0].id: expected a number, found a string");
+    AddError("a fractional id",
+             R"({"sub-flows": [{"id": 1.5, "payload-size": )" + uniform +
+                 R"(, "inter-packet-times": )" + VALID_TIMES + "}]}",
+             "must be an integer between 0 and 65535");
+    AddError("a generator of the wrong type",
+             Profile("[100, 200]", VALID_TIMES),
+             "sub-flows[0].payload-size: expected an object, found an array");
+    AddError("a negative probability",
+             Profile(R"({"type": "dist", "distribution": [{"value": 64, "probability": -1}]})",
+                     VALID_TIMES),
+             "distribution[0].probability: must not be negative");
+    AddError("a max lower than min",
+             Profile(R"({"type": "uniform", "min": 200, "max": 100})", VALID_TIMES),
+             "sub-flows[0].payload-size.max: must not be lower than min");
+    AddError("an unbounded payload size",
+             Profile(R"({"type": "pareto", "scale": 100, "shape": 1.5})", VALID_TIMES),
+             "sub-flows[0].payload-size: a payload size needs a 'max' of at most 4294967295");
+    AddError("a payload size beyond 32 bits",
+             Profile(R"({"type": "lognormal", "mu": 6, "sigma": 1, "max": 1e10})", VALID_TIMES),
+             "sub-flows[0].payload-size.max: must be between 0 and 4294967295 for a payload size");
+    AddError("a negative payload size",
+             Profile(R"({"type": "uniform", "min": -100, "max": 100})", VALID_TIMES),
+             "sub-flows[0].payload-size.min: must be between 0 and 4294967295 for a payload size");
+    AddError("a uniform payload size beyond 32 bits",
+             Profile(R"({"type": "normal", "min": 0, "max": 5e9, "mean": 1e3, "std-dev": 10})",
+                     VALID_TIMES),
+             "sub-flows[0].payload-size.max: must be between 0 and 4294967295");
+    AddError("a negative payload size in a distribution",
+             Profile(R"({"type": "dist", "distribution": [{"value": 64, "probability": 1},
+                                                          {"value": -1, "probability": 0}]})",
+                     VALID_TIMES),
+             "payload-size.distribution[1].value: must be between 0 and 4294967295");
+    AddError("a payload size beyond 32 bits in a distribution",
+             Profile(R"({"type": "dist", "distribution": [{"value": 4294967296, "probability": 1}]})",
+                     VALID_TIMES),
+             "payload-size.distribution[0].value: must be between 0 and 4294967295");
+    AddError("a payload size beyond 32 bits in a CDF",
+             Profile(R"({"type": "empirical", "cdf": [{"value": 100, "cumulative": 0},
+                                                      {"value": 1e12, "cumulative": 1}]})",
+                     VALID_TIMES),
+             "payload-size.cdf[1].value: must be between 0 and 4294967295");
+    AddError("a joint payload size beyond 32 bits",
+             R"({"sub-flows": [{"id": 1, "joint": {"payload-size-edges": [100, 5e9],
+  "inter-packet-time-edges": [0, 1], "weights": [[1]]}}]})",
+             "joint.payload-size-edges[1]: must be at most 4294967295");
+    AddError("an unbounded payload size in a state",
+             R"({"sub-flows": [{"id": 1, "markov": {"states": [
+  {"dwell-time": {"type": "exponential", "mean": 1},
+   "payload-size": {"type": "exponential", "mean": 500},
+   "inter-packet-times": )" + VALID_TIMES + R"(}],
+  "transitions": [[1]]}}]})",
+             "markov.states[0].payload-size: a payload size needs a 'max'");
+    AddError("a negative inter-packet time",
+             Profile(uniform, R"({"type": "uniform", "min": -0.1, "max": 0.1})"),
+             "sub-flows[0].inter-packet-times.min: must not be negative");
+    AddError("a negative inter-packet time in a distribution",
+             Profile(uniform,
+                     R"({"type": "dist", "distribution": [{"value": 0.1, "probability": 1},
+                                                          {"value": -1, "probability": 0}]})"),
+             "inter-packet-times.distribution[1].value: must not be negative");
+    AddError("a negative inter-packet time in a CDF",
+             Profile(uniform,
+                     R"({"type": "empirical", "cdf": [{"value": -0.5, "cumulative": 0},
+                                                      {"value": 0.5, "cumulative": 1}]})"),
+             "inter-packet-times.cdf[0].value: must not be negative");
+    AddError("inter-packet times always 0",
+             Profile(uniform, R"({"type": "uniform", "min": 0, "max": 0})"),
+             "sub-flows[0].inter-packet-times: always draws 0");
+    AddError("a distribution of inter-packet times always 0",
+             Profile(uniform,
+                     R"({"type": "dist", "distribution": [{"value": 0, "probability": 1},
+                                                          {"value": 1, "probability": 0}]})"),
+             "sub-flows[0].inter-packet-times: always draws 0");
+    AddError("joint inter-packet times always 0",
+             R"({"sub-flows": [{"id": 1, "joint": {"payload-size-edges": [100, 200],
+  "inter-packet-time-edges": [0, 0, 1], "weights": [[1, 0]]}}]})",
+             "joint.weights: the inter-packet time is always 0");
+    AddError("a dwell time of 0",
+             R"({"sub-flows": [{"id": 1, "markov": {"states": [
+  {"dwell-time": {"type": "uniform", "min": 0, "max": 1},
+   "payload-size": )" + uniform + R"(, "inter-packet-times": )" + VALID_TIMES + R"(}],
+  "transitions": [[1]]}}]})",
+             "markov.states[0].dwell-time.min: must be positive");
+    AddError("a dwell time of 0 in a distribution",
+             R"({"sub-flows": [{"id": 1, "markov": {"states": [
+  {"dwell-time": {"type": "dist", "distribution": [{"value": 0, "probability": 1}]},
+   "payload-size": )" + uniform + R"(, "inter-packet-times": )" + VALID_TIMES + R"(}],
+  "transitions": [[1]]}}]})",
+             "markov.states[0].dwell-time.distribution[0].value: must be positive");
+    AddError("a duplicate sub-flow id",
+             R"({"sub-flows": [
+  {"id": 1, "payload-size": )" + uniform + R"(, "inter-packet-times": )" + VALID_TIMES + R"(},
+  {"id": 1, "payload-size": )" + uniform + R"(, "inter-packet-times": )" + VALID_TIMES + "}]}",
+             ":3: sub-flows[1].id: duplicate sub-flow id 1");
+    AddError("a duplicate key", R"({"sub-flows": [], "sub-flows": []})", "duplicate key 'sub-flows'");
+
+    // Number grammar
+    AddError("a number without fraction digits",
+             Profile(R"({"type": "uniform", "min": 1., "max": 2})", VALID_TIMES),
+             "invalid number");
+    AddError("a number without exponent digits",
+             Profile(R"({"type": "uniform", "min": 1e+, "max": 2})", VALID_TIMES),
+             "invalid number");
+    AddError("a lone minus sign",
+             Profile(R"({"type": "uniform", "min": -, "max": 2})", VALID_TIMES),
+             "invalid number");
+    AddError("a number with a leading dot",
+             Profile(R"({"type": "uniform", "min": .5, "max": 2})", VALID_TIMES),
+             "unexpected character '.'");
+    AddError("a number with a plus sign",
+             Profile(R"({"type": "uniform", "min": +1, "max": 2})", VALID_TIMES),
+             "unexpected character '+'");
+
+    // Strings
+    AddError("an invalid escape",
+             Profile(R"({"type": "replay", "file": "sizes\x.bin"})", VALID_TIMES),
+             "invalid escape '\\x'");
+    AddError("an invalid \\u escape",
+             Profile(R"({"type": "replay", "file": "\u00g1.bin"})", VALID_TIMES),
+             "invalid \\u escape");
+    AddError("a truncated \\u escape", R"({"sub-flows": "\u00)", "truncated \\u escape");
+    AddError("an unterminated string", R"({"sub-flows)", "unterminated string");
+    AddError("a line break in a string",
+             "{\"sub-\nflows\": []}",
+             ":1: control character in string");
+    AddError("data after the root value", R"({"sub-flows": []} [])", "unexpected data after the root value");
+}
+
+/// Static variable for test initialization
+static TrafficProfileLoaderTestSuite g_trafficProfileLoaderTestSuite;
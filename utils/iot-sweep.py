@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+"""
+Parallel parameter sweep of the IoT camera scenario.
+
+Every combination of client count, traffic profile, simulation time and
+RngRun is simulated as an independent process, with up to one process per
+local core. Each run writes the IotStatsCollector summary of its own run
+directory; once all runs are done, the summaries are merged into a table of
+means and 95% confidence intervals per configuration (the RngRun values
+being the replications).
+
+Example, from the ns-3 root directory:
+
+    ./utils/iot-sweep.py --clients 1 2 4 8 --runs 1-30 --time 90 \\
+        --profile scratch/tapo-c200-move.json --output sweep-results
+
+The scenario must accept the ClientCount, Profile, SimulationTime,
+StatsFile, PacketTrace and Verbose arguments, like scratch/tapo-c200-move.
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import itertools
+import json
+import math
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+# Two-sided 95% Student t quantiles, by degrees of freedom
+T_95 = {
+    1: 12.706, 2: 4.303, 3: 3.182, 4: 2.776, 5: 2.571, 6: 2.447, 7: 2.365,
+    8: 2.306, 9: 2.262, 10: 2.228, 11: 2.201, 12: 2.179, 13: 2.160,
+    14: 2.145, 15: 2.131, 16: 2.120, 17: 2.110, 18: 2.101, 19: 2.093,
+    20: 2.086, 21: 2.080, 22: 2.074, 23: 2.069, 24: 2.064, 25: 2.060,
+    26: 2.056, 27: 2.052, 28: 2.048, 29: 2.045, 30: 2.042, 40: 2.021,
+    60: 2.000, 120: 1.980,
+}
+
+
+def t_quantile(df):
+    """95% quantile for df degrees of freedom, rounded to the safe side."""
+    if df > 120:
+        return 1.960
+    return T_95[max(k for k in T_95 if k <= df)]
+
+
+def parse_runs(spec):
+    """Parse '1-30' or '1,2,5' into a list of RngRun values."""
+    runs = []
+    for part in spec.split(","):
+        if "-" in part:
+            first, last = part.split("-")
+            runs.extend(range(int(first), int(last) + 1))
+        else:
+            runs.append(int(part))
+    return runs
+
+
+def run_command(args, config, run, stats_file):
+    """Command line of one simulation."""
+    program_args = [
+        f"--ClientCount={config['clients']}",
+        f"--Profile={config['profile']}",
+        f"--SimulationTime={config['time']}",
+        f"--RngRun={run}",
+        f"--StatsFile={stats_file}",
+        "--PacketTrace=",
+        "--Verbose=false",
+    ]
+    if args.binary:
+        return [args.binary] + program_args
+    return ["./ns3", "run", " ".join([args.program] + program_args), "--no-build", "--quiet"]
+
+
+def simulate(args, config, run):
+    """Run one simulation, returning its metrics or raising on failure."""
+    name = f"clients{config['clients']}-{os.path.basename(config['profile'])}-t{config['time']}-run{run}"
+    run_dir = os.path.join(args.output, "runs", name)
+    os.makedirs(run_dir, exist_ok=True)
+    stats_file = os.path.join(run_dir, "stats.json")
+
+    with open(os.path.join(run_dir, "output.log"), "w") as log:
+        result = subprocess.run(run_command(args, config, run, stats_file),
+                                cwd=args.ns3_root, stdout=log, stderr=subprocess.STDOUT)
+    if result.returncode != 0:
+        raise RuntimeError(f"{name} exited with status {result.returncode}, see {run_dir}/output.log")
+
+    with open(stats_file) as f:
+        return run_metrics(json.load(f), config["time"])
+
+
+def run_metrics(summary, sim_time):
+    """Reduce a statistics summary to the metrics of one run."""
+    metrics = {"tx_packets": 0, "tx_bytes": 0, "rx_packets": 0, "rx_bytes": 0}
+    for flow in summary["flows"]:
+        if flow["direction"] == "Tx":
+            metrics["tx_packets"] += flow["packets"]
+            metrics["tx_bytes"] += flow["bytes"]
+            prefix = f"subflow{flow['subFlow']}"
+            metrics[prefix + "_tx_packets"] = metrics.get(prefix + "_tx_packets", 0) + flow["packets"]
+            metrics[prefix + "_tx_bytes"] = metrics.get(prefix + "_tx_bytes", 0) + flow["bytes"]
+        else:
+            metrics["rx_packets"] += flow["packets"]
+            metrics["rx_bytes"] += flow["bytes"]
+    metrics["tx_throughput_bps"] = 8 * metrics["tx_bytes"] / sim_time
+    metrics["rx_throughput_bps"] = 8 * metrics["rx_bytes"] / sim_time
+    return metrics
+
+
+def confidence_interval(values):
+    """Mean, standard deviation and 95% confidence half-width of a sample."""
+    mean = statistics.fmean(values)
+    if len(values) < 2:
+        return mean, 0.0, math.nan
+    stddev = statistics.stdev(values)
+    return mean, stddev, t_quantile(len(values) - 1) * stddev / math.sqrt(len(values))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--clients", type=int, nargs="+", default=[1], help="client counts")
+    parser.add_argument("--profile", nargs="+", default=["scratch/tapo-c200-move.json"],
+                        help="traffic profiles")
+    parser.add_argument("--time", type=float, nargs="+", default=[90], help="simulation times, in seconds")
+    parser.add_argument("--runs", default="1-10", help="RngRun values, e.g. 1-30 or 1,4,7")
+    parser.add_argument("--program", default="tapo-c200-move", help="ns3 program to run")
+    parser.add_argument("--binary", help="run this executable directly instead of going through ./ns3")
+    parser.add_argument("--ns3-root", default=".", help="ns-3 root directory")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="parallel simulations")
+    parser.add_argument("--output", default="iot-sweep", help="output directory")
+    parser.add_argument("--no-build", action="store_true", help="do not build the program first")
+    args = parser.parse_args()
+
+    args.ns3_root = os.path.abspath(args.ns3_root)
+    args.output = os.path.abspath(args.output)
+    if args.binary:
+        args.binary = os.path.abspath(args.binary)
+    profiles = [os.path.abspath(p) for p in args.profile]
+    runs = parse_runs(args.runs)
+
+    if not args.binary and not args.no_build:
+        # Build once up front: the runs themselves never build
+        subprocess.run(["./ns3", "build", args.program], cwd=args.ns3_root, check=True)
+
+    configs = [{"clients": c, "profile": p, "time": t}
+               for c, p, t in itertools.product(args.clients, profiles, args.time)]
+    jobs = [(config, run) for config in configs for run in runs]
+    print(f"{len(jobs)} simulations ({len(configs)} configurations x {len(runs)} runs) "
+          f"on {args.jobs} cores", file=sys.stderr)
+
+    # Each worker thread only waits on its simulation process, so the
+    # simulations themselves run in parallel on separate cores
+    start = time.monotonic()
+    results = {}
+    failures = 0
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {pool.submit(simulate, args, config, run): (i, run)
+                   for i, (config, run) in enumerate(jobs)}
+        for done, future in enumerate(concurrent.futures.as_completed(futures), 1):
+            index, run = futures[future]
+            try:
+                results[index] = (run, future.result())
+            except Exception as error:
+                failures += 1
+                print(f"error: {error}", file=sys.stderr)
+            print(f"[{done}/{len(jobs)}] {time.monotonic() - start:.1f} s", file=sys.stderr)
+
+    # Per-run metrics
+    metric_names = sorted({name for _, metrics in results.values() for name in metrics})
+    with open(os.path.join(args.output, "runs.csv"), "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["clients", "profile", "time", "run"] + metric_names)
+        for index in sorted(results):
+            config = jobs[index][0]
+            run, metrics = results[index]
+            writer.writerow([config["clients"], os.path.basename(config["profile"]), config["time"], run]
+                            + [metrics.get(name, 0) for name in metric_names])
+
+    # Merged table: one row per configuration and metric
+    with open(os.path.join(args.output, "summary.csv"), "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["clients", "profile", "time", "metric", "runs", "mean", "stddev",
+                         "ci95_low", "ci95_high"])
+        for config in configs:
+            samples = [metrics for index, (_, metrics) in results.items() if jobs[index][0] is config]
+            if not samples:
+                continue
+            for name in metric_names:
+                mean, stddev, half_width = confidence_interval([m.get(name, 0) for m in samples])
+                writer.writerow([config["clients"], os.path.basename(config["profile"]), config["time"],
+                                 name, len(samples), f"{mean:.6g}", f"{stddev:.6g}",
+                                 f"{mean - half_width:.6g}", f"{mean + half_width:.6g}"])
+
+    print(f"Wrote {args.output}/summary.csv and {args.output}/runs.csv "
+          f"in {time.monotonic() - start:.1f} s", file=sys.stderr)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())